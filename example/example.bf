@@ -71,5 +71,12 @@
 
     ; when . (syscall) is used, most registers will not contain stored values anymore, checkpoints for example
 
+    ; ?save and ?restore keep named checkpoints in registers that survive . and ?call
+    ?save first ; save current position
+
+    >> ?call another_func
+
+    ?restore first ; and back
+
 
     ; explicit return is optional
\ No newline at end of file
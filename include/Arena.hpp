@@ -0,0 +1,112 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// bump allocator for the tokens and parser tables of one compile, blocks are only freed when the arena goes away
+// so whatever lives in it keeps its address for the whole compile
+class Arena{
+    struct alignas(16) Block{
+        Block* prev;
+        size_t size;
+    };
+
+    Block* head = nullptr;
+    char* cur = nullptr;
+    char* end = nullptr;
+
+    void NewBlock(size_t need){
+        size_t size = sizeof(Block) + need;
+        if(size < BlockSize){
+            size = BlockSize;
+        }
+        Block* block = (Block*)std::malloc(size);
+        if(!block){
+            throw std::bad_alloc();
+        }
+        block->prev = head;
+        block->size = size;
+        head = block;
+        cur = (char*)(block + 1);
+        end = (char*)block + size;
+        blocks++;
+    }
+public:
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    size_t allocations = 0;
+    size_t blocks = 0;
+    size_t bytes = 0;
+
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena(){
+        while(head){
+            Block* prev = head->prev;
+            std::free(head);
+            head = prev;
+        }
+    }
+
+    void* Allocate(size_t size, size_t align){
+        allocations++;
+        bytes += size;
+        uintptr_t p = ((uintptr_t)cur + align - 1) & ~(uintptr_t)(align - 1);
+        if(!cur || p + size > (uintptr_t)end){
+            NewBlock(size + align);
+            p = ((uintptr_t)cur + align - 1) & ~(uintptr_t)(align - 1);
+        }
+        cur = (char*)(p + size);
+        return (void*)p;
+    }
+
+    // only the newest allocation can be handed back, like a vector destroyed right after its last growth.
+    // std::vector allocates the new buffer before it frees the old one, so the buffers a growing
+    // vector leaves behind stay in the arena until it goes away
+    void Release(void* ptr, size_t size){
+        if((char*)ptr + size == cur){
+            cur = (char*)ptr;
+        }
+    }
+};
+
+template<typename T>
+struct ArenaAllocator{
+    using value_type = T;
+
+    Arena* arena;
+
+    ArenaAllocator(Arena& a) : arena(&a){};
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena){};
+
+    T* allocate(size_t n){
+        return (T*)arena->Allocate(n * sizeof(T), alignof(T));
+    }
+
+    void deallocate(T* ptr, size_t n){
+        arena->Release(ptr, n * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& rhs) const{
+        return arena == rhs.arena;
+    }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& rhs) const{
+        return arena != rhs.arena;
+    }
+};
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif // ARENA_HPP
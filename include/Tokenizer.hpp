@@ -5,8 +5,10 @@
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <string_view>
 #include <vector>
 #include <cstdint>
+#include "Arena.hpp"
 
 namespace Tokenizer{
     enum class TokenType : uint8_t{
@@ -68,15 +70,16 @@ namespace Tokenizer{
         Special,
     };
 
+    // val points into the source text, which has to outlive the tokens
     struct Token{
-        std::string val;
+        std::string_view val;
         size_t line;
         TokenType type;
         int kwd;
 
         Token() : val(), line(0), type(TokenType::T_NONE), kwd(0){};
 
-        Token(std::string& str, size_t _line, TokenType tp) :
+        Token(std::string_view str, size_t _line, TokenType tp) :
             val(str), line(_line), type(tp){};
 
         Token(const char* str, size_t len, size_t _line, TokenType tp) :
@@ -92,8 +95,8 @@ namespace Tokenizer{
         }
     };
 
-    std::vector<Token> Tokenize(std::string& file, size_t reserve);
-    std::vector<Token> Tokenize(std::string& file);
+    ArenaVector<Token> Tokenize(std::string& file, Arena& arena, size_t reserve);
+    ArenaVector<Token> Tokenize(std::string& file, Arena& arena);
 }
 
 #endif // TOKENIZER_HPP
@@ -1,5 +1,6 @@
 #include "Tokenizer.hpp"
 #include <cstdint>
+#include <utility>
 
 using namespace Tokenizer;
 
@@ -98,6 +99,12 @@ void InitLookup(){
 }
 
 
+inline void EnsureLookup(){
+    // a function local static initializes once even with compiles on several threads
+    static const bool initted = (InitLookup(), true);
+    (void)initted;
+}
+
 enum class TokenizerState : uint8_t{
     Normal,
     Alpha,
@@ -106,19 +113,19 @@ enum class TokenizerState : uint8_t{
 };
 
 struct TokenizerContext{
-    std::vector<Token> tokens;
+    ArenaVector<Token> tokens;
     const char* cur;
     const char* end;
     size_t line = 1;
-    char build[512] = {0};
+    const char* start = nullptr; // first char of the token being built
     unsigned int index = 0;
     CharType look;
     TokenizerState state = TokenizerState::Normal;
     TokenType ct = TokenType::T_NONE;
 
 
-    TokenizerContext(const char* _cur, const char* _end) :
-        cur(_cur), end(_end){};
+    TokenizerContext(const char* _cur, const char* _end, Arena& arena) :
+        tokens(ArenaAllocator<Token>(arena)), cur(_cur), end(_end){};
 };
 
 inline void TAlphaState(TokenizerContext& ctx);
@@ -148,8 +155,11 @@ inline void CallBasedOnType(TokenizerContext& ctx){
     }
 }
 
+// token chars are always consecutive in the source, so only the start and length are kept
 inline void AddChar(TokenizerContext& ctx){
-    ctx.build[ctx.index++] = *ctx.cur;
+    if(ctx.index++ == 0){
+        ctx.start = ctx.cur;
+    }
 }
 
 inline void ClearBuild(TokenizerContext& ctx){
@@ -158,7 +168,7 @@ inline void ClearBuild(TokenizerContext& ctx){
 
 inline void EatToken(TokenizerContext& ctx){
     if(ctx.index > 0){
-        ctx.tokens.emplace_back(ctx.build, ctx.index, ctx.line, ctx.ct);
+        ctx.tokens.emplace_back(ctx.start, ctx.index, ctx.line, ctx.ct);
         ClearBuild(ctx);
     }
 }
@@ -231,14 +241,10 @@ inline void RerouteTokenizer(TokenizerContext& ctx){
     }
 }
 
-std::vector<Token> Tokenizer::Tokenize(std::string& file, size_t reserve){
-    static bool initted = false;
-    if(!initted){
-        InitLookup();
-        initted = true;
-    }
+ArenaVector<Token> Tokenizer::Tokenize(std::string& file, Arena& arena, size_t reserve){
+    EnsureLookup();
 
-    TokenizerContext ctx(file.data(), file.data() + file.size());
+    TokenizerContext ctx(file.data(), file.data() + file.size(), arena);
 
     ctx.tokens.reserve(reserve);
 
@@ -251,10 +257,11 @@ std::vector<Token> Tokenizer::Tokenize(std::string& file, size_t reserve){
 
     EatToken(ctx);
 
-    return ctx.tokens;
+    return std::move(ctx.tokens);
 }
 
 size_t AssumeReserve(std::string& file){
+    EnsureLookup();
     const char* cur = file.data();
     const char* end = file.data() + file.size();
 
@@ -272,6 +279,6 @@ size_t AssumeReserve(std::string& file){
 
     
 
-std::vector<Token> Tokenizer::Tokenize(std::string& file){
-    return Tokenizer::Tokenize(file, AssumeReserve(file));
+ArenaVector<Token> Tokenizer::Tokenize(std::string& file, Arena& arena){
+    return Tokenizer::Tokenize(file, arena, AssumeReserve(file));
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+// runtime support for bf++ programs, link with -lbfpprt when a program needs it
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#define BFPP_PAGE 4096
+#define BFPP_DEFAULT_DEPTH 4096
+
+// emitted by the compiler for --checked-tape, one entry per lowered op
+struct bfpp_line{
+    uintptr_t pc;
+    uintptr_t line;
+    const char* name;
+};
+
+extern const uint64_t __bfpp_tape_stride __attribute__((weak));
+extern const uint64_t __bfpp_line_count __attribute__((weak));
+extern const struct bfpp_line __bfpp_line_table[] __attribute__((weak));
+
+// next free tape slot, the prologue of checked code takes one and the epilogue gives it back
+char* __bfpp_tape_top;
+
+static char* tape_begin;
+static char* tape_limit; // past the last slot, anything from here on means the calls went too deep
+static char* tape_end;
+static char alt_stack[1 << 16];
+
+static size_t format_number(char* buf, uintptr_t val){
+    char tmp[24];
+    size_t len = 0;
+    do{
+        tmp[len++] = '0' + val % 10;
+        val /= 10;
+    } while(val);
+    for(size_t i = 0; i < len; i++){
+        buf[i] = tmp[len - 1 - i];
+    }
+    return len;
+}
+
+static size_t append(char* buf, size_t at, const char* str){
+    size_t len = strlen(str);
+    if(at + len > 255){
+        len = 255 - at;
+    }
+    memcpy(buf + at, str, len);
+    return at + len;
+}
+
+static const struct bfpp_line* find_line(uintptr_t pc){
+    if(!&__bfpp_line_count || __bfpp_line_count == 0 || pc < __bfpp_line_table[0].pc){
+        return NULL;
+    }
+    size_t lo = 0, hi = __bfpp_line_count;
+    while(hi - lo > 1){
+        size_t mid = (lo + hi) / 2;
+        if(__bfpp_line_table[mid].pc <= pc){
+            lo = mid;
+        }
+        else{
+            hi = mid;
+        }
+    }
+    return &__bfpp_line_table[lo];
+}
+
+static void tape_fault(int sig, siginfo_t* info, void* uctx){
+    char* addr = (char*)info->si_addr;
+    if(addr >= tape_begin && addr < tape_end){
+        ucontext_t* uc = (ucontext_t*)uctx;
+        const struct bfpp_line* where = find_line((uintptr_t)uc->uc_mcontext.gregs[REG_RIP]);
+
+        char msg[256];
+        size_t len = 0;
+        if(addr >= tape_limit){
+            len = append(msg, len, "bf++: tape stack exhausted");
+        }
+        else{
+            len = append(msg, len, "bf++: tape access out of bounds");
+        }
+        if(where){
+            len = append(msg, len, " in ");
+            len = append(msg, len, where->name);
+            len = append(msg, len, " near line ");
+            len += format_number(msg + len, where->line);
+        }
+        msg[len++] = '\n';
+        if(write(STDERR_FILENO, msg, len) < 0){
+            // nothing left to report to
+        }
+    }
+    // rerun the access with the default action so the process still dies of SIGSEGV
+    signal(sig, SIG_DFL);
+}
+
+__attribute__((constructor)) static void bfpp_tape_init(void){
+    if(!&__bfpp_tape_stride){
+        return;
+    }
+    if(sysconf(_SC_PAGESIZE) != BFPP_PAGE){
+        static const char msg[] = "bf++: checked tape needs 4096 byte pages\n";
+        if(write(STDERR_FILENO, msg, sizeof(msg) - 1) < 0){
+            // exiting either way
+        }
+        _exit(1);
+    }
+
+    size_t depth = BFPP_DEFAULT_DEPTH;
+    const char* env = getenv("BFPP_TAPE_DEPTH");
+    if(env && atol(env) > 0){
+        depth = (size_t)atol(env);
+    }
+
+    // [guard][slot][guard][slot]...[guard], every slot is followed by the guard of the next one,
+    // one more stride stays inaccessible so running out of slots is reported as such
+    size_t stride = __bfpp_tape_stride;
+    size_t size = (depth + 1) * stride + BFPP_PAGE;
+    char* region = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(region == MAP_FAILED){
+        static const char msg[] = "bf++: could not reserve the tape stack\n";
+        if(write(STDERR_FILENO, msg, sizeof(msg) - 1) < 0){
+            // exiting either way
+        }
+        _exit(1);
+    }
+    for(size_t i = 0; i < depth; i++){
+        mprotect(region + BFPP_PAGE + i * stride, stride - BFPP_PAGE, PROT_READ | PROT_WRITE);
+    }
+    tape_begin = region;
+    tape_limit = region + depth * stride + BFPP_PAGE;
+    tape_end = region + size;
+    __bfpp_tape_top = region + BFPP_PAGE;
+
+    stack_t ss;
+    ss.ss_sp = alt_stack;
+    ss.ss_size = sizeof(alt_stack);
+    ss.ss_flags = 0;
+    sigaltstack(&ss, NULL);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = tape_fault;
+    sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGSEGV, &sa, NULL);
+}
@@ -0,0 +1,163 @@
+// thread pool behind ?spawn and ?join
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef uint64_t (*bfpp_label)(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t);
+
+enum task_state{
+    TASK_PENDING, TASK_RUNNING, TASK_DONE
+};
+
+struct task{
+    bfpp_label fn;
+    uint64_t args[6];
+    uint64_t result;
+    enum task_state state;
+    // links in the shared run queue
+    struct task* prev;
+    struct task* next;
+    // links in the spawning thread's join order
+    struct task* joinNext;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;
+static pthread_once_t started = PTHREAD_ONCE_INIT;
+static struct task* queue_head;
+static struct task* queue_tail;
+
+// ?join always collects the oldest task the current thread spawned
+static __thread struct task* join_head;
+static __thread struct task* join_tail;
+
+static void unlink_task(struct task* t){
+    if(t->prev) t->prev->next = t->next;
+    else queue_head = t->next;
+    if(t->next) t->next->prev = t->prev;
+    else queue_tail = t->prev;
+    t->prev = t->next = NULL;
+}
+
+static void run_task(struct task* t){
+    uint64_t result = t->fn(t->args[0], t->args[1], t->args[2], t->args[3], t->args[4], t->args[5]);
+    pthread_mutex_lock(&lock);
+    t->result = result;
+    t->state = TASK_DONE;
+    pthread_cond_broadcast(&done);
+    pthread_mutex_unlock(&lock);
+}
+
+static void* worker(void* arg){
+    (void)arg;
+    pthread_mutex_lock(&lock);
+    while(1){
+        while(!queue_head){
+            pthread_cond_wait(&work, &lock);
+        }
+        struct task* t = queue_head;
+        unlink_task(t);
+        t->state = TASK_RUNNING;
+        pthread_mutex_unlock(&lock);
+        run_task(t);
+        pthread_mutex_lock(&lock);
+    }
+    return NULL;
+}
+
+static void start_workers(void){
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    const char* env = getenv("BFPP_THREADS");
+    if(env && atol(env) > 0){
+        count = atol(env);
+    }
+    if(count < 1){
+        count = 1;
+    }
+    for(long i = 0; i < count; i++){
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, worker, NULL) == 0){
+            pthread_detach(thread);
+        }
+    }
+}
+
+// called from the __bfpp_spawn stub with the argument registers and the label in regs[6]
+__attribute__((visibility("hidden"))) void __bfpp_spawn_task(const uint64_t* regs){
+    pthread_once(&started, start_workers);
+
+    struct task* t = calloc(1, sizeof(struct task));
+    if(!t){
+        abort();
+    }
+    t->fn = (bfpp_label)regs[6];
+    for(int i = 0; i < 6; i++){
+        t->args[i] = regs[i];
+    }
+    t->state = TASK_PENDING;
+
+    if(join_tail) join_tail->joinNext = t;
+    else join_head = t;
+    join_tail = t;
+
+    pthread_mutex_lock(&lock);
+    t->prev = queue_tail;
+    if(queue_tail) queue_tail->next = t;
+    else queue_head = t;
+    queue_tail = t;
+    pthread_cond_signal(&work);
+    pthread_mutex_unlock(&lock);
+}
+
+uint64_t __bfpp_join(void){
+    struct task* t = join_head;
+    if(!t){
+        return 0;
+    }
+    join_head = t->joinNext;
+    if(!join_head){
+        join_tail = NULL;
+    }
+
+    pthread_mutex_lock(&lock);
+    if(t->state == TASK_PENDING){
+        // nobody picked it up yet, run it here instead of blocking a thread on it
+        unlink_task(t);
+        t->state = TASK_RUNNING;
+        pthread_mutex_unlock(&lock);
+        run_task(t);
+        pthread_mutex_lock(&lock);
+    }
+    while(t->state != TASK_DONE){
+        pthread_cond_wait(&done, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+
+    uint64_t result = t->result;
+    free(t);
+    return result;
+}
+
+// the label comes in r10 so all six argument registers pass through untouched
+__asm__(
+    "\t.text\n"
+    "\t.globl __bfpp_spawn\n"
+    "\t.type __bfpp_spawn, @function\n"
+    "__bfpp_spawn:\n"
+    "\tsubq $56, %rsp\n"
+    "\tmovq %rdi, 0(%rsp)\n"
+    "\tmovq %rsi, 8(%rsp)\n"
+    "\tmovq %rdx, 16(%rsp)\n"
+    "\tmovq %rcx, 24(%rsp)\n"
+    "\tmovq %r8, 32(%rsp)\n"
+    "\tmovq %r9, 40(%rsp)\n"
+    "\tmovq %r10, 48(%rsp)\n"
+    "\tmovq %rsp, %rdi\n"
+    "\tcall __bfpp_spawn_task\n"
+    "\taddq $56, %rsp\n"
+    "\tret\n"
+    "\t.size __bfpp_spawn, .-__bfpp_spawn\n"
+);
@@ -1,9 +1,13 @@
 #include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <fstream>
 #include <ostream>
 #include <sstream>
@@ -11,19 +15,73 @@
 #include <string_view>
 #include <unordered_map>
 #include <vector>
+#include <mutex>
+#include <thread>
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include "Arena.hpp"
 #include "Tokenizer.hpp"
 
 #define SYS_IN 0
 #define SYS_OUT 1
 #define SYS_ERR 2
 #define SYS_OUT_INDEX 1
+#define SYS_IN_INDEX 0
+
+#define TAPE_PAGE 4096
+
+#define PROFILE_MAGIC "BFPPPROF"
+#define PROFILE_FILE "bfpp.prof"
+
+#define MAX_COUNTERS 5 // ?times loops nested in one label plus its checkpoints, one callee saved register each
+#define UNROLL_MAX_OPS 8 // longest ?times body that gets unrolled
+#define UNROLL_MAX 16 // highest --unroll
+#define UNROLL_MAX_GROWTH 64 // most ops one unrolled loop may turn into
+
+// options are per thread, every compile server request runs on its own
+thread_local unsigned int ALLOCATE = 16384;
+thread_local int BASE_OFFSET = 128;
+thread_local unsigned int INLINE_THRESHOLD = 16; // max ops of a label that gets inlined, 0 disables
+thread_local bool STATS = false;
+thread_local bool CHECKED_TAPE = false; // tapes come from the runtime's guard page slots
+thread_local bool FREESTANDING = false; // emit _start, the program is linked without libc
+thread_local bool DEBUG_INFO = false; // -g, source lines and CFI for debuggers and profilers
+thread_local unsigned long long PARTIAL_EVAL = 1000000; // ops of main run at compile time, 0 disables
+thread_local unsigned int UNROLL = 4; // body copies per iteration of short ?times loops, 1 disables
+thread_local bool PROFILE_GENERATE = false; // count label entries and loop iterations into PROFILE_FILE
+thread_local std::string PROFILE_USE; // counts of an earlier --profile-generate run
+thread_local std::vector<std::string> EXPORTS; // --export, labels kept even when main never reaches them
+thread_local bool STREAM = false; // --stream, one label of the source in memory at a time
+
+// where errors and --stats go, the compile server collects them per request
+thread_local std::ostream* DIAGNOSTICS = &std::cerr;
+thread_local std::ostream* REPORT = &std::cout;
+
+inline std::ostream& Diag(){
+    return *DIAGNOSTICS;
+}
 
-unsigned int ALLOCATE = 16384;
-int BASE_OFFSET = 128;
+inline std::ostream& Report(){
+    return *REPORT;
+}
 
 struct BFPPRegisters;
 
 bool CheckAvailable(const char* cmd) {
+    // the answer does not change while we run, only ask the shell once per tool
+    static std::mutex lock;
+    static std::unordered_map<std::string, bool> known;
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = known.find(cmd);
+    if(it != known.end()){
+        return it->second;
+    }
 #ifdef _WIN32
     std::string checkCmd = "where ";
 #else
@@ -37,15 +95,12 @@ bool CheckAvailable(const char* cmd) {
 #endif
 
     int ret = std::system(checkCmd.c_str());
+    known.emplace(cmd, ret == 0);
     return ret == 0;
 }
 
-// used for stuff like syscalls, to keep track of rax's value for example
+// register names, the values are tracked by the register state analysis
 struct Register{
-    long long value = 0;
-    // to keep track if the compiler knows the current value of the register
-    // for example if a function is called rax would be desynced because returns go into rax
-    bool synced = false;
     std::string name, lower32, lower16, lower8;
 
     Register() : name(){};
@@ -75,20 +130,37 @@ enum class Keyword : uint8_t{
     u16,
     u32,
     u64,
+    v128,
+    v256,
+    f32,
+    f64,
     Void,
     mov,
     extrn,
     call,
+    spawn,
+    join,
+    times,
+    include_bin,
+    bin,
+    write,
+    read,
+    step,
+    save,
+    restore,
 };
 
 struct Label{
-    std::string Name;
+    std::string_view Name; // into the source text
     size_t pos;
     unsigned int ptrl; // pointer level, not used
     size_t end = 0;
+    size_t frameAlloc = 0; // tape reservation, ALLOCATE unless the extent analysis bounds it
+    bool frameBounded = false;
     size_t extraAlloc = 0;
+    unsigned int savedRegs = 0; // ?times counter and checkpoint registers pushed after rbp
     Keyword type;
-    Label(std::string& name, size_t _pos, unsigned int _ptrl, Keyword _type) : Name(name), pos(_pos), ptrl(_ptrl), type(_type){};
+    Label(std::string_view name, size_t _pos, unsigned int _ptrl, Keyword _type) : Name(name), pos(_pos), ptrl(_ptrl), type(_type){};
 
     friend std::ostream& operator<<(std::ostream& lhs, const Label& rhs){
         lhs<<rhs.Name;
@@ -96,9 +168,9 @@ struct Label{
     }
 };
 
-// bf++ keywords
+// bf++ keywords, one read only table shared by every compile
 struct BFPPKWD{
-    std::unordered_map<std::string, Keyword> keywords = {
+    std::unordered_map<std::string_view, Keyword> keywords = {
         {"i8", Keyword::i8},
         {"i16", Keyword::i16},
         {"i32", Keyword::i32},
@@ -107,23 +179,76 @@ struct BFPPKWD{
         {"u16", Keyword::u16},
         {"u32", Keyword::u32},
         {"u64", Keyword::u64},
+        {"v128", Keyword::v128},
+        {"v256", Keyword::v256},
+        {"f32", Keyword::f32},
+        {"f64", Keyword::f64},
         {"mov", Keyword::mov},
         {"void", Keyword::Void},
         {"extern", Keyword::extrn},
         {"call", Keyword::call},
+        {"spawn", Keyword::spawn},
+        {"join", Keyword::join},
+        {"times", Keyword::times},
+        {"include_bin", Keyword::include_bin},
+        {"bin", Keyword::bin},
+        {"write", Keyword::write},
+        {"read", Keyword::read},
+        {"step", Keyword::step},
+        {"save", Keyword::save},
+        {"restore", Keyword::restore},
     };
 };
 
+inline BFPPKWD& GetKeywords(){
+    static BFPPKWD keywords;
+    return keywords;
+}
+
 enum class ParsingState{
     Normal,
     Label,
     BFPP,
 };
 
+// Xmm and Ymm are vector cells, lanes are bytes. F32 and F64 are IEEE float cells
 enum class Widths : uint8_t{
-    Byte = 1, Word = 2, Dword = 4, Qword = 8
+    Byte = 1, Word = 2, Dword = 4, Qword = 8, Xmm = 16, Ymm = 32, F32 = 0x44, F64 = 0x48
 };
 
+inline bool IsVectorWidth(Widths width){
+    return width == Widths::Xmm || width == Widths::Ymm;
+}
+
+inline bool IsFloatWidth(Widths width){
+    return width == Widths::F32 || width == Widths::F64;
+}
+
+// float cells and constants travel as their bit pattern, a double rounds to the cell's precision
+inline uint64_t FloatBits(Widths width, double val){
+    if(width == Widths::F32){
+        float f = (float)val;
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof bits);
+        return bits;
+    }
+    uint64_t bits;
+    std::memcpy(&bits, &val, sizeof bits);
+    return bits;
+}
+
+inline double FloatValue(Widths width, uint64_t bits){
+    if(width == Widths::F32){
+        uint32_t low = (uint32_t)bits;
+        float f;
+        std::memcpy(&f, &low, sizeof f);
+        return f;
+    }
+    double d;
+    std::memcpy(&d, &bits, sizeof d);
+    return d;
+}
+
 struct WidthSwitch{
     Widths to;
     size_t pos;
@@ -131,11 +256,18 @@ struct WidthSwitch{
 };
 
 struct MoveValue{
-    long long val;
+    long long val; // the bits of the literal in a float mode
     size_t pos;
     MoveValue(long long v, size_t p) : val(v), pos(p){};
 };
 
+// '?step X', what one '+' or '-' adds to a float cell from here on
+struct FloatStep{
+    double step;
+    size_t pos;
+    FloatStep(double s, size_t p) : step(s), pos(p){};
+};
+
 struct FReturn{
     size_t pos;
     size_t label;
@@ -161,7 +293,7 @@ struct Call{
     std::string_view name;
     size_t pos;
 
-    Call(size_t p, std::string& str) : name(str), pos(p){};
+    Call(size_t p, std::string_view str) : name(str), pos(p){};
 };
 
 struct Loop{
@@ -169,15 +301,111 @@ struct Loop{
     Loop(size_t s, size_t e) : start(s), end(e){};  
 };
 
-// used for codegen
+// '?times N [' or '?times [', the loop runs count times or as often as the cell says when it starts
+struct CountedLoop{
+    size_t pos; // the '['
+    long long count;
+    bool fromCell;
+    CountedLoop(size_t p, long long c, bool cell) : pos(p), count(c), fromCell(cell){};
+};
+
+// '?include_bin name "file"', the file goes into .rodata as it is
+struct BinInclude{
+    std::string_view name;
+    std::string_view path; // as written, relative paths start at the source's directory
+    size_t line;
+    BinInclude(std::string_view n, std::string_view p, size_t l) : name(n), path(p), line(l){};
+};
+
+// '?bin name' points the tape pointer at an included file, '?bin name N' argument register N
+struct BinUse{
+    size_t pos;
+    std::string_view name;
+    unsigned int reg;
+    BinUse(size_t p, std::string_view n, unsigned int r) : pos(p), name(n), reg(r){};
+};
+
+// '?write N' and '?read N', N cells of the current width from the current cell on in one syscall
+struct BlockIO{
+    size_t pos;
+    unsigned long count;
+    bool read;
+    BlockIO(size_t p, unsigned long c, bool r) : pos(p), count(c), read(r){};
+};
+
+// '?save name' keeps the tape pointer in a callee saved register, '?restore name' moves back to it
+struct Checkpoint{
+    size_t pos;
+    std::string_view name;
+    bool restore;
+    Checkpoint(size_t p, std::string_view n, bool r) : pos(p), name(n), restore(r){};
+};
+
+// a code address the checked tape runtime maps back to a source line
+struct LineMark{
+    size_t line;
+    size_t label;
+    LineMark(size_t l, size_t lbl) : line(l), label(lbl){};
+};
+
+// a vectorized zero search the codegen emits once per shape
+struct ScanRoutine{
+    bool left;
+    int width;
+    long long stride;
+    ScanRoutine(bool l, int w, long long s) : left(l), width(w), stride(s){};
+
+    std::string Name() const{
+        return std::string("__bfpp_scan_") + (left ? 'l' : 'r') + std::to_string(width) + 's' + std::to_string(stride);
+    }
+};
+
+// counts from a --profile-generate run, entries per label and iterations per loop
+struct Profile{
+    bool loaded = false;
+    std::vector<uint64_t> labels;
+    std::vector<uint64_t> loops;
+};
+
+// a register as the compile time run of main left it, caller means the bytes it does not know
+// still hold whatever main was called with
+struct PEReg{
+    uint64_t val = 0;
+    uint8_t known = 0; // bit per byte
+    bool caller = true;
+};
+
+// the state main reaches before it needs anything only known at run time
+struct PartialEval{
+    bool done = false;
+    long long lo = 0; // first tape byte of the blob relative to main's starting cell
+    std::vector<uint8_t> tape;
+    std::vector<uint8_t> output;
+    std::vector<PEReg> regs;
+    unsigned long long steps = 0;
+    std::string stop; // what ended the run, for --stats
+    size_t line = 0;
+};
+
+// used for codegen, everything the parser collects lives in the compile's arena
 struct ParsedContext{
-    std::vector<Label> labels;
-    std::vector<WidthSwitch> switches;
-    std::vector<FReturn> rets;
-    std::vector<Call> calls;
-    std::vector<std::string> externs; 
-    std::vector<Loop> loops;
-    std::vector<Loop> done_loops;
+    Arena& arena;
+    ArenaVector<Label> labels{ArenaAllocator<Label>(arena)};
+    ArenaVector<WidthSwitch> switches{ArenaAllocator<WidthSwitch>(arena)};
+    ArenaVector<FloatStep> steps{ArenaAllocator<FloatStep>(arena)};
+    ArenaVector<FReturn> rets{ArenaAllocator<FReturn>(arena)};
+    ArenaVector<Call> calls{ArenaAllocator<Call>(arena)};
+    ArenaVector<Call> spawns{ArenaAllocator<Call>(arena)};
+    ArenaVector<size_t> joins{ArenaAllocator<size_t>(arena)};
+    ArenaVector<std::string_view> externs{ArenaAllocator<std::string_view>(arena)};
+    ArenaVector<Loop> loops{ArenaAllocator<Loop>(arena)};
+    ArenaVector<Loop> done_loops{ArenaAllocator<Loop>(arena)};
+    ArenaVector<CountedLoop> times{ArenaAllocator<CountedLoop>(arena)};
+    ArenaVector<BinInclude> includes{ArenaAllocator<BinInclude>(arena)};
+    ArenaVector<BinUse> binUses{ArenaAllocator<BinUse>(arena)};
+    ArenaVector<BlockIO> io{ArenaAllocator<BlockIO>(arena)};
+    ArenaVector<Checkpoint> checkpoints{ArenaAllocator<Checkpoint>(arena)};
+    size_t ioLoops = 0; // labels of the emitted transfer loops
     size_t pos;
     BFPPKWD& bfpp;
     Tokenizer::Token* curTok;
@@ -186,14 +414,31 @@ struct ParsedContext{
     bool special = false;
     unsigned short ptrl = 0;
     size_t tokensLen;
-    std::vector<Tokenizer::Token>& tokens;
-    std::vector<BFInstruction> ins;
-    std::vector<MoveValue> movs;
+    ArenaVector<Tokenizer::Token>& tokens;
+    ArenaVector<BFInstruction> ins{ArenaAllocator<BFInstruction>(arena)};
+    ArenaVector<MoveValue> movs{ArenaAllocator<MoveValue>(arena)};
     BFPPRegisters& regs;
     BFInstructionType curIns = BFInstructionType::NONE;
     unsigned int insCount = 0;
+    std::vector<LineMark> lineMarks;
+    Widths vectorWidth = Widths::Byte; // widest vector cell the codegen emitted
+    bool vectorConsts[256] = {}; // broadcast byte constants the vector ops load
+    std::vector<std::pair<Widths, uint64_t>> floatConsts; // .rodata constants the float ops load
+    std::vector<ScanRoutine> scans;
+    std::vector<std::string> initRoutines; // startup routines, .init_array or called by _start
+    std::vector<std::string> finiRoutines; // same at exit, .fini_array or called after main returns
+    uint64_t sourceHash = 0; // ties a profile to the source it was recorded for
+    std::string sourceDir = "."; // where relative ?include_bin paths start
+    std::string sourcePath; // what -g names as the source file
+    size_t locLine = 0; // last line -g emitted a .loc for
+    size_t selectRewrites = 0; // generic instructions instruction selection replaced
+    long long selectSaved = 0; // bytes that saved, a rewrite trading size for speed counts negative
+    std::vector<std::string> includePaths; // absolute, one per include
+    Profile profile;
+    PartialEval partial;
+    bool parseFailed = false; // a keyword got an operand it cannot use, the compile stops after parsing
     
-    ParsedContext(std::vector<Tokenizer::Token>& toks, BFPPKWD& bf, BFPPRegisters& _regs) : bfpp(bf), tokensLen(toks.size()), tokens(toks), regs(_regs){};
+    ParsedContext(Arena& _arena, ArenaVector<Tokenizer::Token>& toks, BFPPKWD& bf, BFPPRegisters& _regs) : arena(_arena), bfpp(bf), tokensLen(toks.size()), tokens(toks), regs(_regs){};
 };
 
 inline bool LookableAhead(ParsedContext& ctx){
@@ -281,7 +526,7 @@ inline void NormalParse(ParsedContext& ctx){
     }
     else if(ctx.curTok->type == Tokenizer::TokenType::T_EXCLAMATION){
         if(ctx.labels.empty()){
-            std::cerr<<"Global returns are not permitted"<<std::endl;
+            Diag()<<"Global returns are not permitted"<<std::endl;
             return;
         }
         PushBackInstruction(ctx);
@@ -307,6 +552,109 @@ inline void NormalParse(ParsedContext& ctx){
     }
 }
 
+// the width the ops parsed so far end up with, switches apply in source order across labels
+inline Widths ParsedWidth(ParsedContext& ctx){
+    return ctx.switches.empty() ? Widths::Byte : ctx.switches.back().to;
+}
+
+// a decimal or hex count, false for anything else or a number that does not fit
+inline bool ParseCount(Tokenizer::Token& tok, unsigned long long& out){
+    if(tok.type != Tokenizer::TokenType::T_DECIMAL && tok.type != Tokenizer::TokenType::T_HEX){
+        return false;
+    }
+    std::string text(tok.val);
+    errno = 0;
+    char* end = nullptr;
+    out = std::strtoull(text.c_str(), &end, tok.type == Tokenizer::TokenType::T_HEX ? 16 : 10);
+    return *end == '\0' && errno != ERANGE;
+}
+
+// end of a decimal or hex float literal in the raw source, the tokenizer splits
+// exponents like 1e-3 and hex floats like 0x1.8p3 into several tokens
+inline const char* FloatLiteralEnd(const char* p){
+    bool hex = p[0] == '0' && (p[1] == 'x' || p[1] == 'X');
+    auto digit = [hex](char c){
+        return hex ? std::isxdigit((unsigned char)c) != 0 : std::isdigit((unsigned char)c) != 0;
+    };
+    if(hex){
+        p += 2;
+    }
+    while(digit(*p)){
+        p++;
+    }
+    if(*p == '.'){
+        p++;
+        while(digit(*p)){
+            p++;
+        }
+    }
+    if(std::tolower((unsigned char)*p) == (hex ? 'p' : 'e')){
+        const char* exp = p + 1;
+        if(*exp == '+' || *exp == '-'){
+            exp++;
+        }
+        if(std::isdigit((unsigned char)*exp)){
+            while(std::isdigit((unsigned char)*exp)){
+                exp++;
+            }
+            p = exp;
+        }
+    }
+    return p;
+}
+
+// a number for ?mov and ?step in a float mode, the tokenizer keeps a leading '-' on its own
+inline bool ParseFloatLiteral(ParsedContext& ctx, const char* what, double& out){
+    bool negative = false;
+    if(LookableAhead(ctx) && LookAhead(ctx).type == Tokenizer::TokenType::T_MINUS){
+        negative = true;
+        ctx.pos++;
+    }
+    if(!LookableAhead(ctx)){
+        Diag()<<"Error on "<<what<<" instruction, abruptly ended on line "<<ctx.curTok->line<<std::endl;
+        ctx.parseFailed = true;
+        return false;
+    }
+    Tokenizer::Token& tok = LookAhead(ctx);
+    if(tok.type != Tokenizer::TokenType::T_DECIMAL && tok.type != Tokenizer::TokenType::T_FLOAT &&
+       tok.type != Tokenizer::TokenType::T_HEX){
+        ctx.pos++;
+        Diag()<<"Unknown value on "<<what<<" instruction on line "<<tok.line<<std::endl;
+        ctx.parseFailed = true;
+        return false;
+    }
+    // the literal is the raw text, whatever tokens it became get skipped
+    const char* start = tok.val.data();
+    const char* end = FloatLiteralEnd(start);
+    while(LookableAhead(ctx) && LookAhead(ctx).val.data() < end){
+        ctx.pos++;
+    }
+    if(std::isalnum((unsigned char)*end) || *end == '_'){
+        Diag()<<"Unknown value on "<<what<<" instruction on line "<<tok.line<<std::endl;
+        ctx.parseFailed = true;
+        return false;
+    }
+    std::string text(start, end - start);
+    errno = 0;
+    char* parsed = nullptr;
+    // f32 parses straight to float, rounding through double first can be off by one ulp
+    out = ParsedWidth(ctx) == Widths::F32 ? std::strtof(text.c_str(), &parsed) : std::strtod(text.c_str(), &parsed);
+    if(*parsed != '\0'){
+        Diag()<<"Unknown value on "<<what<<" instruction on line "<<tok.line<<std::endl;
+        ctx.parseFailed = true;
+        return false;
+    }
+    if(errno == ERANGE && std::isinf(out)){
+        Diag()<<"Value out of range on "<<what<<" instruction on line "<<tok.line<<std::endl;
+        ctx.parseFailed = true;
+        return false;
+    }
+    if(negative){
+        out = -out;
+    }
+    return true;
+}
+
 inline void BFPPParse(ParsedContext& ctx){
     Keyword kwd = (Keyword)ctx.curTok->kwd;
     if(kwd == Keyword::None){
@@ -325,22 +673,44 @@ inline void BFPPParse(ParsedContext& ctx){
     else if(kwd == Keyword::i64 || kwd == Keyword::u64){
         ctx.switches.emplace_back(Widths::Qword, ctx.pos);
     }
+    else if(kwd == Keyword::v128){
+        ctx.switches.emplace_back(Widths::Xmm, ctx.pos);
+    }
+    else if(kwd == Keyword::v256){
+        ctx.switches.emplace_back(Widths::Ymm, ctx.pos);
+    }
+    else if(kwd == Keyword::f32){
+        ctx.switches.emplace_back(Widths::F32, ctx.pos);
+    }
+    else if(kwd == Keyword::f64){
+        ctx.switches.emplace_back(Widths::F64, ctx.pos);
+    }
+    else if(kwd == Keyword::step){
+        double step;
+        if(ParseFloatLiteral(ctx, "step", step)){
+            ctx.steps.emplace_back(step, ctx.pos);
+        }
+    }
+    else if(kwd == Keyword::mov && IsFloatWidth(ParsedWidth(ctx))){
+        double val;
+        if(ParseFloatLiteral(ctx, "mov", val)){
+            ctx.movs.emplace_back(FloatBits(ParsedWidth(ctx), val), ctx.pos);
+        }
+    }
     else if(kwd == Keyword::mov){
         if(LookableAhead(ctx)){
             Tokenizer::Token& tok = LookAhead(ctx);
             ctx.pos++;
-            if(tok.type == Tokenizer::TokenType::T_DECIMAL){
-                ctx.movs.emplace_back(std::stoul(tok.val), ctx.pos);
-            }
-            else if(tok.type == Tokenizer::TokenType::T_HEX){
-                ctx.movs.emplace_back(std::stoul(tok.val, nullptr, 16), ctx.pos);
+            unsigned long long val = 0;
+            if(ParseCount(tok, val)){
+                ctx.movs.emplace_back(val, ctx.pos);
             }
             else{
-                std::cerr<<"Unknown value on mov instruction on line "<<tok.line<<std::endl;
+                Diag()<<"Unknown value on mov instruction on line "<<tok.line<<std::endl;
             }
         }
         else{
-            std::cerr<<"Error on mov instruction, abruptly ended on line "<<ctx.curTok->line<<std::endl;
+            Diag()<<"Error on mov instruction, abruptly ended on line "<<ctx.curTok->line<<std::endl;
         }
     }
     else if(kwd == Keyword::extrn){
@@ -351,11 +721,11 @@ inline void BFPPParse(ParsedContext& ctx){
                 ctx.externs.emplace_back(tok.val);
             }
             else{
-                std::cerr<<"Unknown token on extern instruction on line "<<tok.line<<std::endl;
+                Diag()<<"Unknown token on extern instruction on line "<<tok.line<<std::endl;
             }
         }
         else{
-            std::cerr<<"Error on extern instruction, abruptly ended on line "<<ctx.curTok->line<<std::endl;
+            Diag()<<"Error on extern instruction, abruptly ended on line "<<ctx.curTok->line<<std::endl;
         }
     }
     else if(kwd == Keyword::call){
@@ -366,11 +736,146 @@ inline void BFPPParse(ParsedContext& ctx){
                 ctx.calls.emplace_back(ctx.pos, tok.val);
             }
             else{
-                std::cerr<<"Unknown token on call instruction on line "<<tok.line<<std::endl;
+                Diag()<<"Unknown token on call instruction on line "<<tok.line<<std::endl;
+            }
+        }
+        else{
+            Diag()<<"Error on call instruction, abruptly ended on line "<<ctx.curTok->line<<std::endl;
+        }
+    }
+    else if(kwd == Keyword::spawn){
+        if(LookableAhead(ctx)){
+            Tokenizer::Token& tok = LookAhead(ctx);
+            ctx.pos++;
+            if(tok.type == Tokenizer::TokenType::T_ALPHA){
+                ctx.spawns.emplace_back(ctx.pos, tok.val);
+            }
+            else{
+                Diag()<<"Unknown token on spawn instruction on line "<<tok.line<<std::endl;
+            }
+        }
+        else{
+            Diag()<<"Error on spawn instruction, abruptly ended on line "<<ctx.curTok->line<<std::endl;
+        }
+    }
+    else if(kwd == Keyword::join){
+        ctx.joins.push_back(ctx.pos);
+    }
+    else if(kwd == Keyword::include_bin){
+        if(LookableAhead(ctx) && LookAhead(ctx).type == Tokenizer::TokenType::T_ALPHA){
+            ctx.pos++;
+            std::string_view name = ctx.tokens[ctx.pos].val;
+            if(LookableAhead(ctx) && LookAhead(ctx).type == Tokenizer::TokenType::T_STRING){
+                // the path is the raw text up to the closing quote, whatever tokens it became get skipped
+                const char* start = LookAhead(ctx).val.data() + 1;
+                const char* end = start;
+                while(*end != '\0' && *end != '"' && *end != '\n'){
+                    end++;
+                }
+                if(*end == '"'){
+                    ctx.includes.emplace_back(name, std::string_view(start, end - start), ctx.curTok->line);
+                }
+                else{
+                    Diag()<<"Error on include_bin instruction, unterminated path on line "<<ctx.curTok->line<<std::endl;
+                }
+                while(LookableAhead(ctx) && LookAhead(ctx).val.data() <= end){
+                    ctx.pos++;
+                }
+            }
+            else{
+                Diag()<<"Error on include_bin instruction, expected a quoted path on line "<<ctx.curTok->line<<std::endl;
+            }
+        }
+        else{
+            Diag()<<"Error on include_bin instruction, expected a name on line "<<ctx.curTok->line<<std::endl;
+        }
+    }
+    else if(kwd == Keyword::bin){
+        if(LookableAhead(ctx) && LookAhead(ctx).type == Tokenizer::TokenType::T_ALPHA){
+            ctx.pos++;
+            std::string_view name = ctx.tokens[ctx.pos].val;
+            size_t pos = ctx.pos;
+            unsigned int reg = 0;
+            if(LookableAhead(ctx) && LookAhead(ctx).type == Tokenizer::TokenType::T_DECIMAL){
+                ctx.pos++;
+                unsigned long long value = 0;
+                if(!ParseCount(ctx.tokens[ctx.pos], value) || value > 6){
+                    Diag()<<"Unknown register on bin instruction on line "<<ctx.tokens[ctx.pos].line<<", only 1 to 6 can be loaded"<<std::endl;
+                    ctx.parseFailed = true;
+                }
+                else{
+                    reg = value;
+                }
+            }
+            ctx.binUses.emplace_back(pos, name, reg);
+        }
+        else{
+            Diag()<<"Error on bin instruction, expected a name on line "<<ctx.curTok->line<<std::endl;
+            ctx.parseFailed = true;
+        }
+    }
+    else if(kwd == Keyword::write || kwd == Keyword::read){
+        const char* what = kwd == Keyword::write ? "write" : "read";
+        if(LookableAhead(ctx)){
+            Tokenizer::Token& tok = LookAhead(ctx);
+            ctx.pos++;
+            unsigned long long count = 0;
+            // the count ends up in a 32 bit op field
+            if(ParseCount(tok, count) && count <= std::numeric_limits<unsigned int>::max()){
+                ctx.io.emplace_back(ctx.pos, count, kwd == Keyword::read);
+            }
+            else{
+                Diag()<<"Unknown value on "<<what<<" instruction on line "<<tok.line<<std::endl;
+                ctx.parseFailed = true;
+            }
+        }
+        else{
+            Diag()<<"Error on "<<what<<" instruction, abruptly ended on line "<<ctx.curTok->line<<std::endl;
+            ctx.parseFailed = true;
+        }
+    }
+    else if(kwd == Keyword::save || kwd == Keyword::restore){
+        const char* what = kwd == Keyword::save ? "save" : "restore";
+        if(LookableAhead(ctx)){
+            Tokenizer::Token& tok = LookAhead(ctx);
+            ctx.pos++;
+            if(tok.type == Tokenizer::TokenType::T_ALPHA){
+                ctx.checkpoints.emplace_back(ctx.pos, tok.val, kwd == Keyword::restore);
+            }
+            else{
+                Diag()<<"Unknown token on "<<what<<" instruction on line "<<tok.line<<std::endl;
+                ctx.parseFailed = true;
+            }
+        }
+        else{
+            Diag()<<"Error on "<<what<<" instruction, abruptly ended on line "<<ctx.curTok->line<<std::endl;
+            ctx.parseFailed = true;
+        }
+    }
+    else if(kwd == Keyword::times){
+        long long count = 0;
+        bool fromCell = true;
+        if(LookableAhead(ctx)){
+            Tokenizer::Token& tok = LookAhead(ctx);
+            if(tok.type == Tokenizer::TokenType::T_DECIMAL || tok.type == Tokenizer::TokenType::T_HEX){
+                unsigned long long value = 0;
+                if(!ParseCount(tok, value) || value > (unsigned long long)std::numeric_limits<long long>::max()){
+                    Diag()<<"Unknown value on times instruction on line "<<tok.line<<std::endl;
+                    ctx.parseFailed = true;
+                }
+                count = value;
+                fromCell = false;
+                ctx.pos++;
+            }
+        }
+        if(LookableAhead(ctx) && LookAhead(ctx).type == Tokenizer::TokenType::T_LSQUARE){
+            if(!ctx.parseFailed){
+                ctx.times.emplace_back(ctx.pos + 1, count, fromCell);
             }
         }
         else{
-            std::cerr<<"Error on call instruction, abruptly ended on line "<<ctx.curTok->line<<std::endl;
+            Diag()<<"Error on times instruction, expected [ on line "<<ctx.curTok->line<<std::endl;
+            ctx.parseFailed = true;
         }
     }
     ctx.state = ParsingState::Normal;
@@ -394,6 +899,10 @@ inline bool IsType(Keyword kwd){
             return true;
         case Keyword::u64:
             return true;
+        case Keyword::f32:
+            return true;
+        case Keyword::f64:
+            return true;
         case Keyword::Void:
             return true;
         default:
@@ -445,16 +954,19 @@ inline void ParsingStateHandle(ParsedContext& ctx){
     }
 }
 
-ParsedContext ParseTokensBFPP(std::vector<Tokenizer::Token> toks, BFPPKWD& bf, BFPPRegisters& regs){
-    ParsedContext out(toks, bf, regs);
-
-    for(out.pos = 0; out.pos < out.tokensLen; out.pos++){
-        out.curTok = &toks[out.pos];
-        ParsingStateHandle(out);
+void ParseTokens(ParsedContext& ctx){
+    for(ctx.pos = 0; ctx.pos < ctx.tokensLen; ctx.pos++){
+        ctx.curTok = &ctx.tokens[ctx.pos];
+        ParsingStateHandle(ctx);
     }
     Tokenizer::Token temp;
-    out.curTok = &temp;
-    ParsingStateHandle(out);
+    ctx.curTok = &temp;
+    ParsingStateHandle(ctx);
+}
+
+ParsedContext ParseTokensBFPP(Arena& arena, ArenaVector<Tokenizer::Token>& toks, BFPPKWD& bf, BFPPRegisters& regs){
+    ParsedContext out(arena, toks, bf, regs);
+    ParseTokens(out);
     return out;
 }
 
@@ -465,7 +977,27 @@ std::string FileIntoString(const char* fileName){
     return ss.str(); 
 }
 
-void ClassifyTokens(std::vector<Tokenizer::Token>& toks, BFPPKWD& bf){
+void RemoveLineComments(std::string& str, char symb){
+    size_t len = str.size();
+
+    bool incom = false;
+    for(size_t i = 0; i < len; i++){
+
+        if(str[i] == '\n') incom = false;
+
+        if(incom){
+            str[i] = ' ';
+        }
+        else{
+            if(str[i] == symb){
+                incom = true;
+                str[i] = ' ';
+            }
+        }
+    }
+}
+
+void ClassifyTokens(ArenaVector<Tokenizer::Token>& toks, BFPPKWD& bf){
     for(Tokenizer::Token& tok : toks){
         auto it = bf.keywords.find(tok.val);
         if(it != bf.keywords.end()){
@@ -499,7 +1031,7 @@ inline const char* GetByteAlignSyntax(){
 }
 
 enum class AssemblyInstruction{
-    ADD, SUB, MOV, PUSH, POP, RET, SYSCALL, CMP
+    ADD, SUB, MOV, PUSH, POP, RET, SYSCALL, CMP, INC, DEC, XOR
 };
 
 inline const char* GenerateSuffix(Widths width){
@@ -509,8 +1041,10 @@ inline const char* GenerateSuffix(Widths width){
         case Widths::Word:
             return "w";
         case Widths::Dword:
+        case Widths::F32:
             return "l";
         case Widths::Qword:
+        case Widths::F64:
             return "q";
         default:
             return "";
@@ -535,6 +1069,12 @@ inline const char* GenerateOperation(AssemblyInstruction ins){
             return "syscall";
         case AssemblyInstruction::CMP:
             return "cmp";
+        case AssemblyInstruction::INC:
+            return "inc";
+        case AssemblyInstruction::DEC:
+            return "dec";
+        case AssemblyInstruction::XOR:
+            return "xor";
     }
 }
 
@@ -545,6 +1085,7 @@ inline std::string& GetRegisterWidth(Register& reg, Widths width){
         case Widths::Word:
             return reg.lower16;
         case Widths::Dword:
+        case Widths::F32:
             return reg.lower32;
         case Widths::Qword:
             return reg.name;
@@ -604,7 +1145,7 @@ struct BFPPRegisters{
     Register r12 = {"r12", "r12d", "r12w", "r12b"};
     Register r13 = {"r13", "r13d", "r13w", "r13b"};
     Register r14 = {"r14", "r14d", "r14w", "r14b"};
-    Register r15 = {"r15", "r15d", "r15w", "r15w"};
+    Register r15 = {"r15", "r15d", "r15w", "r15b"};
 
     Register rip = {"rip", "eip", "ip", ""};
 
@@ -628,13 +1169,6 @@ inline std::string AlignTo(unsigned int alignment, bool power = true){
     return end;
 }
 
-inline std::ofstream& GenerateGlobals(ParsedContext& ctx, std::ofstream& file){
-    for(Label& lbl : ctx.labels){
-        file<<'\t'<<GetGlobalSyntax()<<' '<<lbl.Name<<std::endl;
-    }
-    return file;
-}
-
 inline std::ofstream& GenerateLabelEndName(Label& lbl, std::ofstream& file){
     file<<"__"<<lbl<<"__end__"<<std::to_string(lbl.pos);
     return file;
@@ -659,37 +1193,206 @@ inline int GetMultiplier(Widths width){
             return 4;
         case Widths::Qword:
             return 8;
+        case Widths::Xmm:
+            return 16;
+        case Widths::Ymm:
+            return 32;
+        case Widths::F32:
+            return 4;
+        case Widths::F64:
+            return 8;
+    }
+}
+
+inline size_t TapeStride(){
+    // a slot of whole pages plus the guard page after it
+    return ((size_t)ALLOCATE + TAPE_PAGE - 1) / TAPE_PAGE * TAPE_PAGE + TAPE_PAGE;
+}
+
+// ?times counters live in callee saved registers so calls keep them, one per nesting level
+inline Register& GetCounterRegister(BFPPRegisters& regs, unsigned int slot){
+    switch(slot){
+        case 0:
+            return regs.rbx;
+        case 1:
+            return regs.r12;
+        case 2:
+            return regs.r13;
+        case 3:
+            return regs.r14;
+        default:
+            return regs.r15;
+    }
+}
+
+// what the prologue takes from rsp, an odd number of saved registers needs 8 more to keep calls aligned
+inline size_t FrameAdjust(Label& lbl){
+    return lbl.frameAlloc + lbl.extraAlloc + (lbl.savedRegs % 2) * 8;
+}
+
+// -g call frame information, rbp holds the tape so the CFA is always relative to rsp
+inline void GenerateCFAOffset(std::ofstream& file, size_t offset){
+    if(DEBUG_INFO){
+        file<<'\t'<<".cfi_def_cfa_offset "<<offset<<std::endl;
+    }
+}
+
+inline void GenerateCFISaved(std::ofstream& file, Register& reg, size_t offset){
+    if(DEBUG_INFO){
+        file<<'\t'<<".cfi_offset "<<GenerateRegisterOP(reg)<<", -"<<offset<<std::endl;
+    }
+}
+
+inline void GenerateCFIRestore(std::ofstream& file, Register& reg){
+    if(DEBUG_INFO){
+        file<<'\t'<<".cfi_restore "<<GenerateRegisterOP(reg)<<std::endl;
+    }
+}
+
+// the return address, rbp and the counter registers
+inline size_t SavedBytes(Label& lbl){
+    return 16 + lbl.savedRegs * 8;
+}
+
+// the frame as the prologue leaves it, for code outside the function's own FDE
+inline void GenerateFrameCFI(ParsedContext& ctx, std::ofstream& file, Label& lbl){
+    GenerateCFAOffset(file, SavedBytes(lbl) + FrameAdjust(lbl));
+    GenerateCFISaved(file, ctx.regs.frameReg, 16);
+    for(unsigned int r = 0; r < lbl.savedRegs; r++){
+        GenerateCFISaved(file, GetCounterRegister(ctx.regs, r), 24 + r * 8);
+    }
+}
+
+inline std::ofstream& GenerateDirectToReg(std::ofstream& file, long long direct, Register& reg){
+    file<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
+    file<<GenerateDirectOP(direct)<<", "<<GenerateRegisterOP(reg);
+    return file;
+}
+
+// instruction selection, the ops map to generic add/sub/mov forms and these pick the shortest
+// or cheapest encoding that does the same, each rewrite adds the bytes it saved for --stats
+inline bool IsExtendedRegister(Register& reg){
+    return reg.name[1] >= '0' && reg.name[1] <= '9';
+}
+
+inline void CountSelection(ParsedContext& ctx, long long saved){
+    ctx.selectRewrites++;
+    ctx.selectSaved += saved;
+}
+
+// movq $imm is 7 bytes, a 32 bit write zero extends so small constants take movl and 0 takes xor.
+// xor clobbers the flags, no register load sits between a flag write and the jump reading it
+inline std::ofstream& SelectRegisterConstant(ParsedContext& ctx, std::ofstream& file, long long val, Register& reg){
+    if(val == 0){
+        file<<GenerateInstruction(AssemblyInstruction::XOR, Widths::Dword)<<' ';
+        file<<'%'<<reg.lower32<<", %"<<reg.lower32;
+        CountSelection(ctx, IsExtendedRegister(reg) ? 4 : 5);
+        return file;
+    }
+    if(val > 0 && val <= INT32_MAX){
+        file<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Dword)<<' ';
+        file<<GenerateDirectOP(val)<<", %"<<reg.lower32;
+        CountSelection(ctx, IsExtendedRegister(reg) ? 1 : 2);
+        return file;
+    }
+    return GenerateDirectToReg(file, val, reg);
+}
+
+// add/sub of a constant to a cell or the tape pointer. the sign extended imm8 stops at 127 so 128
+// flips to the other instruction with -128, a 1 on a register becomes inc/dec. inc/dec on memory
+// would be shorter too but cost an extra uop on Intel, and the zero flag the loop tests read
+// comes out the same for every form
+inline std::ofstream& SelectAdd(ParsedContext& ctx, std::ofstream& file, bool add, Widths width, long long val, const std::string& dst, bool reg){
+    file<<'\t';
+    if(reg && val == 1){
+        file<<GenerateInstruction(add ? AssemblyInstruction::INC : AssemblyInstruction::DEC, width)<<' '<<dst;
+        CountSelection(ctx, 1);
+    }
+    else if(val == 128 && width != Widths::Byte){
+        file<<GenerateInstruction(add ? AssemblyInstruction::SUB : AssemblyInstruction::ADD, width)<<' ';
+        file<<GenerateDirectOP(-128)<<", "<<dst;
+        CountSelection(ctx, width == Widths::Word ? 1 : 3);
+    }
+    else{
+        file<<GenerateInstruction(add ? AssemblyInstruction::ADD : AssemblyInstruction::SUB, width)<<' ';
+        file<<GenerateDirectOP(val)<<", "<<dst;
     }
+    file<<std::endl;
+    return file;
 }
 
-inline std::ofstream& GeneratePrologue(ParsedContext& ctx, std::ofstream& file){
+inline std::ofstream& GeneratePrologue(ParsedContext& ctx, std::ofstream& file, Label& lbl){
     // push rbp
     file<<'\t'<<GeneratePushRegister(ctx.regs.frameReg, Widths::Qword)<<std::endl;
+    GenerateCFAOffset(file, 16);
+    GenerateCFISaved(file, ctx.regs.frameReg, 16);
+    for(unsigned int r = 0; r < lbl.savedRegs; r++){
+        file<<'\t'<<GeneratePushRegister(GetCounterRegister(ctx.regs, r), Widths::Qword)<<std::endl;
+        GenerateCFAOffset(file, 24 + r * 8);
+        GenerateCFISaved(file, GetCounterRegister(ctx.regs, r), 24 + r * 8);
+    }
 
     // sub allocation from rsp
-    file<<'\t'<<GenerateInstruction(AssemblyInstruction::SUB, Widths::Qword)<<' ';
-    file<<GenerateDirectOP(ALLOCATE)<<", "<<GenerateRegisterOP(ctx.regs.stackReg)<<std::endl;
+    if(FrameAdjust(lbl) > 0){
+        SelectAdd(ctx, file, false, Widths::Qword, FrameAdjust(lbl), GenerateRegisterOP(ctx.regs.stackReg), true);
+        GenerateCFAOffset(file, SavedBytes(lbl) + FrameAdjust(lbl));
+    }
 
-    // mov rbp to rsp
-    file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
-    file<<GenerateRegisterOP(ctx.regs.stackReg)<<", "<<GenerateRegisterOP(ctx.regs.frameReg)<<std::endl;
+    if(CHECKED_TAPE){
+        // take the next guarded slot
+        file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
+        file<<"__bfpp_tape_top(%rip), "<<GenerateRegisterOP(ctx.regs.frameReg)<<std::endl;
+        file<<'\t'<<GenerateInstruction(AssemblyInstruction::ADD, Widths::Qword)<<' ';
+        file<<GenerateDirectOP(TapeStride())<<", __bfpp_tape_top(%rip)"<<std::endl;
+    }
+    else if(BASE_OFFSET > 0){
+        // rbp is rsp plus the offset, one lea instead of mov and add
+        file<<'\t'<<"leaq "<<BASE_OFFSET<<GenerateMemRegisterOP(ctx.regs.stackReg)<<", "<<GenerateRegisterOP(ctx.regs.frameReg)<<std::endl;
+        CountSelection(ctx, 2);
+        return file;
+    }
+    else{
+        // mov rbp to rsp
+        file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
+        file<<GenerateRegisterOP(ctx.regs.stackReg)<<", "<<GenerateRegisterOP(ctx.regs.frameReg)<<std::endl;
+    }
     
     // sub offset from rbp
     if(BASE_OFFSET > 0){
-        file<<'\t'<<GenerateInstruction(AssemblyInstruction::ADD, Widths::Qword)<<' ';
-        file<<GenerateDirectOP(BASE_OFFSET)<<", "<<GenerateRegisterOP(ctx.regs.frameReg)<<std::endl;
+        SelectAdd(ctx, file, true, Widths::Qword, BASE_OFFSET, GenerateRegisterOP(ctx.regs.frameReg), true);
     }
     return file;
 }
 
-inline std::ofstream& GenerateEpilogue(ParsedContext& ctx, std::ofstream& file, Label& lbl){
+inline std::ofstream& GenerateFrameTeardown(ParsedContext& ctx, std::ofstream& file, Label& lbl){
+    if(CHECKED_TAPE){
+        // give the slot back
+        file<<'\t'<<GenerateInstruction(AssemblyInstruction::SUB, Widths::Qword)<<' ';
+        file<<GenerateDirectOP(TapeStride())<<", __bfpp_tape_top(%rip)"<<std::endl;
+    }
+
     // add back to rsp
-    file<<'\t'<<GenerateInstruction(AssemblyInstruction::ADD, Widths::Qword)<<' ';
-    file<<GenerateDirectOP(ALLOCATE + lbl.extraAlloc)<<", "<<GenerateRegisterOP(ctx.regs.stackReg)<<std::endl;
+    if(FrameAdjust(lbl) > 0){
+        SelectAdd(ctx, file, true, Widths::Qword, FrameAdjust(lbl), GenerateRegisterOP(ctx.regs.stackReg), true);
+        GenerateCFAOffset(file, SavedBytes(lbl));
+    }
+    for(unsigned int r = lbl.savedRegs; r > 0; r--){
+        file<<'\t'<<GenerateInstruction(AssemblyInstruction::POP, Widths::Qword)<<' ';
+        file<<GenerateRegisterOP(GetCounterRegister(ctx.regs, r - 1))<<std::endl;
+        GenerateCFAOffset(file, 8 + r * 8);
+        GenerateCFIRestore(file, GetCounterRegister(ctx.regs, r - 1));
+    }
 
     // pop rbp
     file<<'\t'<<GenerateInstruction(AssemblyInstruction::POP, Widths::Qword)<<' ';
     file<<GenerateRegisterOP(ctx.regs.frameReg)<<std::endl;
+    GenerateCFAOffset(file, 8);
+    GenerateCFIRestore(file, ctx.regs.frameReg);
+    return file;
+}
+
+inline std::ofstream& GenerateEpilogue(ParsedContext& ctx, std::ofstream& file, Label& lbl){
+    GenerateFrameTeardown(ctx, file, lbl);
 
     // return
     file<<'\t'<<GenerateInstruction(AssemblyInstruction::RET, Widths::Byte)<<std::endl;
@@ -704,357 +1407,3929 @@ inline const char* GetUJumpSyntax(){
     return "jmp";
 }
 
-inline void GenerateInstructionComment(std::ofstream& file, BFInstruction& ins){
-    char cc;
-    switch(ins.type){
-        case BFInstructionType::LEFT:
-            cc = '<';
-            break;
-        case BFInstructionType::RIGHT:
-            cc = '>';
-            break;
-        case BFInstructionType::PLUS:
-            cc = '+';
-            break;
+enum class BFOpType : uint8_t{
+    PLUS, MINUS, LEFT, RIGHT, OUTPUT, ARGUMENT, GETARG, MOV, CALL, RET, LOOP_START, LOOP_END,
+    INLINE_START, INLINE_RET, INLINE_END, TAIL_CALL, SPAWN, JOIN, SCAN, PRELOAD, BIN, WRITE, READ, SAVE, RESTORE
+};
+
+// what an op is called in messages
+inline const char* OpTypeName(BFOpType type){
+    switch(type){
+        case BFOpType::PLUS: return "'+'";
+        case BFOpType::MINUS: return "'-'";
+        case BFOpType::LEFT: return "'<'";
+        case BFOpType::RIGHT: return "'>'";
+        case BFOpType::OUTPUT: return "'.'";
+        case BFOpType::ARGUMENT: return "argument";
+        case BFOpType::GETARG: return "'^'";
+        case BFOpType::MOV: return "?mov";
+        case BFOpType::CALL: return "?call";
+        case BFOpType::RET: return "'!'";
+        case BFOpType::LOOP_START: return "'['";
+        case BFOpType::LOOP_END: return "']'";
+        case BFOpType::INLINE_START:
+        case BFOpType::INLINE_RET:
+        case BFOpType::INLINE_END: return "inlined call";
+        case BFOpType::TAIL_CALL: return "tail call";
+        case BFOpType::SPAWN: return "?spawn";
+        case BFOpType::JOIN: return "?join";
+        case BFOpType::SCAN: return "scan";
+        case BFOpType::PRELOAD: return "preload";
+        case BFOpType::BIN: return "?bin";
+        case BFOpType::WRITE: return "?write";
+        case BFOpType::READ: return "?read";
+        case BFOpType::SAVE: return "?save";
+        case BFOpType::RESTORE: return "?restore";
+    }
+    return "op";
+}
+
+// the parsed side tables flattened into source order, one op per emitted construct
+struct BFOp{
+    BFOpType type;
+    Widths width;
+    size_t pos;
+    unsigned int count = 0;
+    bool address = false;
+    long long val = 0;
+    size_t target = 0; // loop index for loops, label index for returns, inline index for inlined calls, routine for scans
+    size_t match = 0; // op index of the other end of a loop or inlined call
+    std::string_view name;
+    uint8_t hoist = 0; // registers loaded in front of a loop, bit per TrackedRegister
+    uint8_t clobbers = 0xFF; // registers a ?call can change, all of them unless the callee is an analyzed label
+    long long hoistFrame = 0; // tape offset the hoisted buffer register points at
+    bool counted = false; // ?times loop, runs val times or as often as the cell says when fromCell
+    bool fromCell = false;
+    uint8_t counter = 0; // counter register slot of a ?times loop or a checkpoint
+
+    BFOp(BFOpType t, Widths w, size_t p) : type(t), width(w), pos(p){};
+};
+
+enum class RegValueKind : uint8_t{
+    Unknown, Constant, Frame
+};
+
+// what the compiler knows about a register, Frame means tape pointer + value
+struct RegValue{
+    RegValueKind kind = RegValueKind::Unknown;
+    long long value = 0;
+
+    RegValue(){};
+    RegValue(RegValueKind k, long long v) : kind(k), value(v){};
+
+    bool operator==(const RegValue& rhs) const{
+        return kind == rhs.kind && (kind == RegValueKind::Unknown || value == rhs.value);
+    }
+
+    bool operator!=(const RegValue& rhs) const{
+        return !(*this == rhs);
+    }
+};
+
+enum TrackedRegister : uint8_t{
+    TR_RAX, TR_ARG1, TR_ARG2, TR_ARG3, TR_ARG4, TR_ARG5, TR_ARG6, TR_COUNT
+};
+
+struct RegisterState{
+    bool reachable = false;
+    RegValue regs[TR_COUNT];
+
+    bool operator==(const RegisterState& rhs) const{
+        if(reachable != rhs.reachable) return false;
+        for(int r = 0; r < TR_COUNT; r++){
+            if(regs[r] != rhs.regs[r]) return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const RegisterState& rhs) const{
+        return !(*this == rhs);
+    }
+};
+
+struct BFFunction{
+    size_t label;
+    std::vector<BFOp> ops;
+    std::vector<RegisterState> regIn; // register state before each op
+    bool structured = true; // false when a loop crosses the label boundary
+    bool avx = false; // uses 256 bit cells, so every vector op is VEX encoded
+    uint64_t weight = 0; // profiled entries plus loop iterations
+    bool hot = false;
+    bool live = true; // reachable from main or exported
+    bool folded = false; // another label's body is the same, this one is only a symbol on it
+    std::vector<size_t> aliases; // labels folded into this body
+    uint8_t clobbers = 0xFF; // tracked registers a call of this label can change
+
+    BFFunction(size_t lbl) : label(lbl){};
+};
+
+inline Register& GetTrackedRegister(BFPPRegisters& regs, TrackedRegister reg){
+    switch(reg){
+        case TR_ARG1:
+            return regs.arg1;
+        case TR_ARG2:
+            return regs.arg2;
+        case TR_ARG3:
+            return regs.arg3;
+        case TR_ARG4:
+            return regs.arg4;
+        case TR_ARG5:
+            return regs.arg5;
+        case TR_ARG6:
+            return regs.arg6;
+        default:
+            return regs.rax;
+    }
+}
+
+// registers the write syscall of '.' needs, in load order
+const TrackedRegister OutputRegisters[] = {TR_RAX, TR_ARG1, TR_ARG2, TR_ARG3};
+
+inline RegValue OutputSetup(TrackedRegister reg){
+    switch(reg){
+        case TR_RAX:
+            return RegValue(RegValueKind::Constant, SYS_OUT_INDEX);
+        case TR_ARG1:
+            return RegValue(RegValueKind::Constant, SYS_OUT);
+        case TR_ARG2:
+            return RegValue(RegValueKind::Frame, 0);
+        case TR_ARG3:
+            return RegValue(RegValueKind::Constant, 1);
+        default:
+            return RegValue();
+    }
+}
+
+inline void PushOp(std::vector<BFFunction>& funcs, BFOp op){
+    // anything before the first label is never executed
+    if(!funcs.empty()){
+        funcs.back().ops.push_back(op);
+    }
+}
+
+inline BFOpType GetOpType(BFInstructionType type){
+    switch(type){
+        case BFInstructionType::LEFT:
+            return BFOpType::LEFT;
+        case BFInstructionType::RIGHT:
+            return BFOpType::RIGHT;
+        case BFInstructionType::PLUS:
+            return BFOpType::PLUS;
         case BFInstructionType::MINUS:
-            cc = '-';
-            break;
+            return BFOpType::MINUS;
         case BFInstructionType::OUTPUT:
-            cc = '.';
-            break;
+            return BFOpType::OUTPUT;
         case BFInstructionType::ARGUMENT:
-            cc = '*';
-            break;
-        case BFInstructionType::LOOP:
-            cc = '[';
-            break;
-        case BFInstructionType::GETARG:
-            cc = '&';
-            break;
+            return BFOpType::ARGUMENT;
         default:
-            cc = ' ';
-            break;
+            return BFOpType::GETARG;
     }
-    for(size_t i = 0; i < ins.count; i++){
-        file<<cc;
+}
+
+void MatchLoops(BFFunction& fn){
+    std::vector<size_t> open;
+    for(size_t i = 0; i < fn.ops.size(); i++){
+        BFOp& op = fn.ops[i];
+        if(op.type == BFOpType::LOOP_START || op.type == BFOpType::INLINE_START){
+            open.push_back(i);
+        }
+        else if(op.type == BFOpType::LOOP_END || op.type == BFOpType::INLINE_END){
+            if(open.empty() || fn.ops[open.back()].target != op.target){
+                fn.structured = false;
+                return;
+            }
+            op.match = open.back();
+            fn.ops[open.back()].match = i;
+            open.pop_back();
+        }
+    }
+    if(!open.empty()){
+        fn.structured = false;
     }
 }
 
-inline std::ofstream& GenerateDirectToReg(std::ofstream& file, long long direct, Register& reg){
-    file<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
-    file<<GenerateDirectOP(direct)<<", "<<GenerateRegisterOP(reg);
-    return file;
+// deepest nesting of ?times loops, every level needs its own counter register
+int CountedDepth(std::vector<BFOp>& ops){
+    int depth = 0, deepest = 0;
+    for(BFOp& op : ops){
+        if(op.counted && op.type == BFOpType::LOOP_START){
+            deepest = std::max(deepest, ++depth);
+        }
+        else if(op.counted && op.type == BFOpType::LOOP_END){
+            depth--;
+        }
+    }
+    return deepest;
 }
 
-inline void UnsyncRegister(Register& reg){
-    reg.synced = false;
+// checkpoint names of a label in order of first use, each keeps its register for the whole label
+std::vector<std::string_view> CheckpointNames(std::vector<BFOp>& ops){
+    std::vector<std::string_view> names;
+    for(BFOp& op : ops){
+        if((op.type == BFOpType::SAVE || op.type == BFOpType::RESTORE) && std::find(names.begin(), names.end(), op.name) == names.end()){
+            names.push_back(op.name);
+        }
+    }
+    return names;
 }
 
-inline void UnsyncAll(BFPPRegisters& regs){
-    UnsyncRegister(regs.arg1);
-    UnsyncRegister(regs.arg2);
-    UnsyncRegister(regs.arg3);
-    UnsyncRegister(regs.arg4);
-    UnsyncRegister(regs.arg5);
-    UnsyncRegister(regs.arg6);
-    UnsyncRegister(regs.rax);
+// walks the side tables in the same order the codegen always consumed them
+std::vector<BFFunction> LowerParsed(ParsedContext& ctx){
+    std::vector<BFFunction> funcs;
+
+    std::vector<size_t> loopStarts(ctx.done_loops.size());
+    for(size_t l = 0; l < loopStarts.size(); l++){
+        loopStarts[l] = l;
+    }
+    std::sort(loopStarts.begin(), loopStarts.end(), [&ctx](size_t a, size_t b){
+        return ctx.done_loops[a].start < ctx.done_loops[b].start;
+    });
+
+    // the ?times that opened each loop, if any
+    std::vector<CountedLoop*> counted(ctx.done_loops.size(), nullptr);
+    for(size_t k = 0, t = 0; k < loopStarts.size(); k++){
+        size_t start = ctx.done_loops[loopStarts[k]].start;
+        for(; t < ctx.times.size() && ctx.times[t].pos < start; t++);
+        if(t < ctx.times.size() && ctx.times[t].pos == start){
+            counted[loopStarts[k]] = &ctx.times[t];
+        }
+    }
+
+    size_t ls = 0, le = 0, c = 0, sp = 0, j = 0, b = 0, io = 0, k = 0, m = 0, s = 0, st = 0, n = 0, r = 0, l = 0;
+    Widths currentWidth = Widths::Byte;
+    double currentStep = 1.0;
+
+    for(size_t i = 0; i < ctx.pos; i++){
+        for(; ls < loopStarts.size() && ctx.done_loops[loopStarts[ls]].start <= i; ls++){
+            BFOp op(BFOpType::LOOP_START, currentWidth, i);
+            op.target = loopStarts[ls];
+            if(counted[op.target] != nullptr){
+                op.counted = true;
+                op.fromCell = counted[op.target]->fromCell;
+                op.val = counted[op.target]->count;
+            }
+            PushOp(funcs, op);
+        }
+        for(; le < ctx.done_loops.size() && ctx.done_loops[le].end <= i; le++){
+            BFOp op(BFOpType::LOOP_END, currentWidth, i);
+            op.target = le;
+            op.counted = counted[le] != nullptr;
+            PushOp(funcs, op);
+        }
+        for(; c < ctx.calls.size() && ctx.calls[c].pos <= i; c++){
+            BFOp op(BFOpType::CALL, currentWidth, i);
+            op.name = ctx.calls[c].name;
+            PushOp(funcs, op);
+        }
+        for(; sp < ctx.spawns.size() && ctx.spawns[sp].pos <= i; sp++){
+            BFOp op(BFOpType::SPAWN, currentWidth, i);
+            op.name = ctx.spawns[sp].name;
+            PushOp(funcs, op);
+        }
+        for(; j < ctx.joins.size() && ctx.joins[j] <= i; j++){
+            PushOp(funcs, BFOp(BFOpType::JOIN, currentWidth, i));
+        }
+        for(; b < ctx.binUses.size() && ctx.binUses[b].pos <= i; b++){
+            BFOp op(BFOpType::BIN, currentWidth, i);
+            op.name = ctx.binUses[b].name;
+            op.count = ctx.binUses[b].reg;
+            PushOp(funcs, op);
+        }
+        for(; io < ctx.io.size() && ctx.io[io].pos <= i; io++){
+            BFOp op(ctx.io[io].read ? BFOpType::READ : BFOpType::WRITE, currentWidth, i);
+            op.count = ctx.io[io].count;
+            PushOp(funcs, op);
+        }
+        for(; k < ctx.checkpoints.size() && ctx.checkpoints[k].pos <= i; k++){
+            BFOp op(ctx.checkpoints[k].restore ? BFOpType::RESTORE : BFOpType::SAVE, currentWidth, i);
+            op.name = ctx.checkpoints[k].name;
+            PushOp(funcs, op);
+        }
+        for(; m < ctx.movs.size() && ctx.movs[m].pos <= i; m++){
+            BFOp op(BFOpType::MOV, currentWidth, i);
+            op.val = ctx.movs[m].val;
+            PushOp(funcs, op);
+        }
+        for(; s < ctx.switches.size() && ctx.switches[s].pos <= i; s++){
+            currentWidth = ctx.switches[s].to;
+        }
+        for(; st < ctx.steps.size() && ctx.steps[st].pos <= i; st++){
+            currentStep = ctx.steps[st].step;
+        }
+        for(; n < ctx.ins.size() && ctx.ins[n].pos <= i; n++){
+            BFInstruction& ins = ctx.ins[n];
+            if(ins.type == BFInstructionType::NONE || ins.type == BFInstructionType::LOOP){
+                continue;
+            }
+            BFOp op(GetOpType(ins.type), currentWidth, i);
+            op.count = ins.count;
+            op.address = ins.address;
+            if(IsFloatWidth(currentWidth) && (op.type == BFOpType::PLUS || op.type == BFOpType::MINUS)){
+                // a run adds count steps in one go, rounded once
+                op.val = FloatBits(currentWidth, ins.count * currentStep);
+            }
+            PushOp(funcs, op);
+        }
+        for(; r < ctx.rets.size() && ctx.rets[r].pos <= i; r++){
+            BFOp op(BFOpType::RET, currentWidth, i);
+            op.target = ctx.rets[r].label;
+            PushOp(funcs, op);
+        }
+        for(; l < ctx.labels.size() && ctx.labels[l].pos <= i; l++){
+            funcs.emplace_back(l);
+        }
+    }
+
+    for(BFFunction& fn : funcs){
+        MatchLoops(fn);
+    }
+    return funcs;
 }
 
-inline std::ofstream& GenerateExterns(ParsedContext& ctx, std::ofstream& file){
-    for(std::string& str : ctx.externs){
-        file<<'\t'<<GetExternSyntax()<<' '<<str<<std::endl;
+// a profile is only trusted for the exact source it was recorded from
+inline uint64_t HashSource(const std::string& src){
+    uint64_t hash = 14695981039346656037ULL;
+    for(unsigned char c : src){
+        hash = (hash ^ c) * 1099511628211ULL;
     }
-    return file;
+    return hash;
 }
 
-inline const char* GetCallSyntax(){
-    return "call";
+// a missing or stale profile only costs the optimizations, the compile goes on without it
+void LoadProfile(ParsedContext& ctx, const std::string& path){
+    std::ifstream in(path, std::ios::binary);
+    if(!in){
+        Diag()<<"bf++: warning: cannot open profile "<<path<<", compiling without it"<<std::endl;
+        return;
+    }
+    char magic[8];
+    uint64_t hash = 0, labels = 0, loops = 0;
+    if(!in.read(magic, 8) || std::memcmp(magic, PROFILE_MAGIC, 8) != 0 || !in.read((char*)&hash, 8) ||
+        !in.read((char*)&labels, 8) || !in.read((char*)&loops, 8)){
+        Diag()<<"bf++: warning: "<<path<<" is not a bf++ profile, compiling without it"<<std::endl;
+        return;
+    }
+    if(hash != ctx.sourceHash || labels != ctx.labels.size() || loops != ctx.done_loops.size()){
+        Diag()<<"bf++: warning: "<<path<<" was recorded for a different source, compiling without it"<<std::endl;
+        return;
+    }
+    ctx.profile.labels.resize(labels);
+    ctx.profile.loops.resize(loops);
+    if(!in.read((char*)ctx.profile.labels.data(), labels * 8) || !in.read((char*)ctx.profile.loops.data(), loops * 8)){
+        Diag()<<"bf++: warning: "<<path<<" is truncated, compiling without it"<<std::endl;
+        return;
+    }
+    ctx.profile.loaded = true;
 }
 
-void BFPPCodegen(ParsedContext& ctx, const char* file_out){
-    std::ofstream file(file_out);
-    if(!file){
-        std::cerr<<"Error opening file for codegen"<<std::endl;
+// has to run before inlining and scan lowering move the loops around
+void ApplyProfile(ParsedContext& ctx, std::vector<BFFunction>& funcs){
+    if(!ctx.profile.loaded){
         return;
     }
-    
-    GenerateTextSectionGAS(file)<<'\n';
+    uint64_t heaviest = 0;
+    for(BFFunction& fn : funcs){
+        fn.weight = ctx.profile.labels[fn.label];
+        for(BFOp& op : fn.ops){
+            if(op.type == BFOpType::LOOP_START && op.target < ctx.profile.loops.size()){
+                fn.weight += ctx.profile.loops[op.target];
+            }
+        }
+        heaviest = std::max(heaviest, fn.weight);
+    }
+    for(BFFunction& fn : funcs){
+        fn.hot = fn.weight > 0 && fn.weight >= heaviest / 16;
+    }
+}
 
-    GenerateGlobals(ctx, file)<<'\n';
-    GenerateExterns(ctx, file)<<'\n';
+// hot labels first so they share cache lines and pages, source order without a profile
+std::vector<size_t> LayoutOrder(ParsedContext& ctx, std::vector<BFFunction>& funcs){
+    std::vector<size_t> order(funcs.size());
+    for(size_t f = 0; f < order.size(); f++){
+        order[f] = f;
+    }
+    if(ctx.profile.loaded){
+        std::stable_sort(order.begin(), order.end(), [&funcs](size_t a, size_t b){
+            return funcs[a].weight > funcs[b].weight;
+        });
+    }
+    return order;
+}
 
-    bool labelEnd = false;
-    size_t labelEndIndex = 0;
+// a loop that never ran in the profile, its body moves out of the function's hot path
+inline bool IsColdLoop(ParsedContext& ctx, BFFunction& fn, BFOp& op){
+    return ctx.profile.loaded && fn.structured && fn.weight > 0 && !op.counted &&
+        op.target < ctx.profile.loops.size() && ctx.profile.loops[op.target] == 0;
+}
 
-    size_t lblsize = ctx.labels.size();
-    size_t retsize = ctx.rets.size();
-    size_t switches = ctx.switches.size();
-    size_t inslen = ctx.ins.size();
-    size_t loopsize = ctx.done_loops.size();
+// compile time interpreter for the start of main. Tapes start unknown like the stack they live on,
+// anything that reads an unknown byte, input, an extern or the budget ends the run
 
-    Widths currentWidth = Widths::Byte;
+// the most a partially evaluated program writes in one go
+#define PE_MAX_OUTPUT (1 << 20)
+#define PE_MAX_DEPTH 64
+// steps a call costs on top of its ops, setting up the frame is not free
+#define PE_CALL_COST 64
 
-    for(size_t i = 0; i < ctx.pos; i++){
-        for(size_t l = 0; l < loopsize; l++){
-            Loop& loop = ctx.done_loops[l];
-            if(loop.start == i){
-                file<<'\t'<<"__loop__start__"<<std::to_string(l)<<':'<<std::endl;
-                file<<'\t'<<GenerateInstruction(AssemblyInstruction::CMP, currentWidth)<<' ';
-                file<<GenerateDirectOP(0)<<", "<<GenerateMemRegisterOP(ctx.regs.frameReg)<<std::endl;
-                file<<'\t'<<"je "<<"__loop__end__"<<std::to_string(l)<<std::endl;
-            }
-            else if(loop.end == i){
-                file<<'\t'<<GetUJumpSyntax()<<' '<<"__loop__start__"<<std::to_string(l)<<std::endl;
-                file<<'\t'<<"__loop__end__"<<std::to_string(l)<<':'<<std::endl;
-            }
-        }
-        for(Call& call : ctx.calls){
-            if(call.pos == i){
-                UnsyncAll(ctx.regs);
-                file<<'\t'<<GetCallSyntax()<<' '<<call.name<<std::endl;
-                file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
-                file<<'%'<<GetRegisterWidth(ctx.regs.rax, currentWidth)<<", ";
-                file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<std::endl;
-            }
+// a frame only grows as far as it is written, up to ALLOCATE bytes
+struct PEFrame{
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> known;
+    long long ptr = 0; // relative to the starting cell
+
+    void Reset(){
+        bytes.clear();
+        known.clear();
+        ptr = 0;
+    }
+};
+
+struct PEState{
+    ParsedContext& ctx;
+    std::vector<BFFunction>& funcs;
+    std::unordered_map<std::string_view, size_t> byName;
+    std::vector<PEReg> regs;
+    std::vector<uint8_t> output;
+    unsigned long long steps = 0;
+    std::string stop;
+    size_t stopPos = 0;
+    std::vector<PEFrame> frames; // one per call depth, reused so a call does not allocate its tape again
+
+    PEState(ParsedContext& c, std::vector<BFFunction>& f) : ctx(c), funcs(f), regs(TR_COUNT), frames(PE_MAX_DEPTH + 1){};
+};
+
+inline bool PEStop(PEState& st, BFOp& op, const char* why){
+    st.stop = why;
+    st.stopPos = op.pos;
+    return false;
+}
+
+// the cell has to lie in the frame and every byte of it be known
+inline bool PECell(PEFrame& fr, int bytes, long long& idx){
+    idx = fr.ptr + BASE_OFFSET;
+    if(idx < 0 || idx + bytes > (long long)fr.bytes.size()){
+        return false;
+    }
+    for(int b = 0; b < bytes; b++){
+        if(!fr.known[idx + b]){
+            return false;
         }
-        for(MoveValue& mov : ctx.movs){
-            if(mov.pos == i){
-                file<<'\t';
-                file<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
-                file<<GenerateDirectOP(mov.val)<<", "<<GenerateMemRegisterOP(ctx.regs.frameReg);
-                file<<std::endl;
-            }
+    }
+    return true;
+}
+
+inline bool PEWritable(PEFrame& fr, int bytes, long long& idx){
+    idx = fr.ptr + BASE_OFFSET;
+    if(idx < 0 || idx + bytes > (long long)ALLOCATE){
+        return false;
+    }
+    if(idx + bytes > (long long)fr.bytes.size()){
+        size_t size = std::min<size_t>(ALLOCATE, std::max<size_t>({(size_t)(idx + bytes), fr.bytes.size() * 2, 256}));
+        fr.bytes.resize(size);
+        fr.known.resize(size);
+    }
+    return true;
+}
+
+inline uint64_t PELoad(PEFrame& fr, long long idx, int bytes){
+    uint64_t val = 0;
+    for(int b = std::min(bytes, 8) - 1; b >= 0; b--){
+        val = (val << 8) | fr.bytes[idx + b];
+    }
+    return val;
+}
+
+inline void PEStore(PEFrame& fr, long long idx, int bytes, uint64_t val){
+    for(int b = 0; b < bytes; b++){
+        fr.bytes[idx + b] = b < 8 ? (val >> (b * 8)) & 0xFF : 0;
+        fr.known[idx + b] = 1;
+    }
+}
+
+// mov into the low bytes of a register, 32 bit writes zero the upper half like the hardware
+inline void PESetReg(PEReg& reg, int bytes, uint64_t val){
+    if(bytes >= 4){
+        reg.val = bytes == 4 ? val & 0xFFFFFFFFULL : val;
+        reg.known = 0xFF;
+        return;
+    }
+    uint64_t mask = (1ULL << (bytes * 8)) - 1;
+    reg.val = (reg.val & ~mask) | (val & mask);
+    reg.known |= (1 << bytes) - 1;
+}
+
+inline void PEClobber(PEReg& reg){
+    reg.known = 0;
+    reg.caller = false;
+}
+
+// addss/subss round once to float, the same sum done in double could round twice
+inline uint64_t PEFloatAdd(Widths width, uint64_t cell, uint64_t step, bool add){
+    if(width == Widths::F32){
+        float a = (float)FloatValue(width, cell), b = (float)FloatValue(width, step);
+        return FloatBits(width, add ? a + b : a - b);
+    }
+    double a = FloatValue(width, cell), b = FloatValue(width, step);
+    return FloatBits(width, add ? a + b : a - b);
+}
+
+// a loop over a float cell runs while it is ordered and not zero, -0.0 and NaN end it like ucomiss does
+inline bool PEFloatTrue(Widths width, uint64_t cell){
+    double v = FloatValue(width, cell);
+    return v < 0 || v > 0;
+}
+
+bool PERun(PEState& st, PEFrame& fr, BFFunction& fn, size_t from, size_t to, int depth);
+
+bool PECall(PEState& st, PEFrame& fr, BFOp& op, int depth){
+    auto it = st.byName.find(op.name);
+    if(it == st.byName.end()){
+        return PEStop(st, op, "extern call");
+    }
+    BFFunction& callee = st.funcs[it->second];
+    if(!callee.structured || depth >= PE_MAX_DEPTH){
+        return PEStop(st, op, "call");
+    }
+    st.steps += PE_CALL_COST;
+    if(st.steps > PARTIAL_EVAL){
+        return PEStop(st, op, "step budget");
+    }
+    PEFrame& inner = st.frames[depth + 1];
+    inner.Reset();
+    if(!PERun(st, inner, callee, 0, callee.ops.size(), depth + 1)){
+        return false;
+    }
+    int bytes = GetMultiplier(op.width);
+    long long idx;
+    uint8_t need = (1 << bytes) - 1;
+    if(!PEWritable(fr, bytes, idx) || (st.regs[TR_RAX].known & need) != need){
+        return PEStop(st, op, "unknown return value");
+    }
+    PEStore(fr, idx, bytes, st.regs[TR_RAX].val);
+    return true;
+}
+
+// runs ops [from, to), loops jump around inside the range, false once something needs run time
+bool PERun(PEState& st, PEFrame& fr, BFFunction& fn, size_t from, size_t to, int depth){
+    std::unordered_map<size_t, uint64_t> counters; // iterations left per running ?times loop
+    for(size_t i = from; i < to; i++){
+        BFOp& op = fn.ops[i];
+        if(++st.steps > PARTIAL_EVAL){
+            return PEStop(st, op, "step budget");
         }
-        for(size_t s = 0; s < switches; s++){
-            WidthSwitch& sw = ctx.switches[s];
-            if(sw.pos == i){
-                currentWidth = sw.to;
-            }
-        }
-        for(size_t j = 0; j < inslen; j++){
-            BFInstruction& ins = ctx.ins[j];
-            if(ins.pos == i){
-                if(ins.type == BFInstructionType::PLUS){
-                    file<<'\t'<<GenerateInstruction(AssemblyInstruction::ADD, currentWidth)<<' ';
-                    file<<GenerateDirectOP(ins.count)<<", "<<GenerateMemRegisterOP(ctx.regs.frameReg);
-                    file<<std::endl;
-                }
-                else if(ins.type == BFInstructionType::MINUS){
-                    file<<'\t'<<GenerateInstruction(AssemblyInstruction::SUB, currentWidth)<<' ';
-                    file<<GenerateDirectOP(ins.count)<<", "<<GenerateMemRegisterOP(ctx.regs.frameReg);
-                    file<<std::endl;
-                }
-                else if(ins.type == BFInstructionType::LEFT){
-                    file<<'\t'<<GenerateInstruction(AssemblyInstruction::SUB, Widths::Qword)<<' ';
-                    file<<GenerateDirectOP(ins.count * GetMultiplier(currentWidth))<<", "<<GenerateRegisterOP(ctx.regs.frameReg);
-                    file<<std::endl;
-                }
-                else if(ins.type == BFInstructionType::RIGHT){
-                    file<<'\t'<<GenerateInstruction(AssemblyInstruction::ADD, Widths::Qword)<<' ';
-                    file<<GenerateDirectOP(ins.count * GetMultiplier(currentWidth))<<", "<<GenerateRegisterOP(ctx.regs.frameReg);
-                    file<<std::endl;
-                }
-                else if(ins.type == BFInstructionType::OUTPUT){
-                    for(size_t c = 0; c < ins.count; c++){
-                        if(ctx.regs.rax.synced == false || ctx.regs.rax.value != SYS_OUT_INDEX){
-                            ctx.regs.rax.synced = true;
-                            ctx.regs.rax.value = SYS_OUT_INDEX;
-                            file<<'\t';
-                            GenerateDirectToReg(file, SYS_OUT_INDEX, ctx.regs.rax)<<std::endl;
-                        }
-                        if(ctx.regs.rdi.synced == false || ctx.regs.rdi.value != SYS_OUT){
-                            ctx.regs.rdi.synced = true;
-                            ctx.regs.rdi.value = SYS_OUT;
-                            file<<'\t';
-                            GenerateDirectToReg(file, SYS_OUT, ctx.regs.rdi)<<std::endl;
-                        }
-                        if(ctx.regs.rsi.synced == false){
-                            ctx.regs.rsi.synced = true;
-                            // cannot guarantee value
-                            file<<'\t';
-                            file<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
-                            file<<GenerateRegisterOP(ctx.regs.frameReg)<<", "<<GenerateRegisterOP(ctx.regs.rsi);
-                            file<<std::endl;
-                        }
-                        if(ctx.regs.rdx.synced == false || ctx.regs.rdx.value != 1){
-                            ctx.regs.rdx.synced = true;
-                            ctx.regs.rdx.value = 1;
-                            file<<'\t';
-                            GenerateDirectToReg(file, 1, ctx.regs.rdx)<<std::endl;
-                        }
-                        file<<'\t'<<GenerateInstruction(AssemblyInstruction::SYSCALL, Widths::Byte)<<std::endl;
-                        UnsyncRegister(ctx.regs.rcx);
-                        UnsyncRegister(ctx.regs.r11);
+        int bytes = GetMultiplier(op.width);
+        long long idx;
+        switch(op.type){
+            case BFOpType::LEFT:
+                fr.ptr -= (long long)op.count * bytes;
+                break;
+            case BFOpType::RIGHT:
+                fr.ptr += (long long)op.count * bytes;
+                break;
+            case BFOpType::PLUS:
+            case BFOpType::MINUS:{
+                if(!PECell(fr, bytes, idx)){
+                    return PEStop(st, op, "unknown cell");
+                }
+                uint64_t delta = op.type == BFOpType::PLUS ? op.count : -(uint64_t)op.count;
+                if(IsFloatWidth(op.width)){
+                    PEStore(fr, idx, bytes, PEFloatAdd(op.width, PELoad(fr, idx, bytes), op.val, op.type == BFOpType::PLUS));
+                }
+                else if(IsVectorWidth(op.width)){
+                    // every lane on its own
+                    for(int b = 0; b < bytes; b++){
+                        fr.bytes[idx + b] += (uint8_t)delta;
                     }
                 }
-                else if(ins.type == BFInstructionType::ARGUMENT){
-                    if(ins.count <= 6){
-                        Register* reg;
-                        switch(ins.count){
-                            case 1:
-                                reg = &ctx.regs.arg1;
-                                break;
-                            case 2:
-                                reg = &ctx.regs.arg2;
-                                break;
-                            case 3:
-                                reg = &ctx.regs.arg3;
-                                break;
-                            case 4:
-                                reg = &ctx.regs.arg4;
-                                break;
-                            case 5:
-                                reg = &ctx.regs.arg5;
-                                break;
-                            case 6:
-                                reg = &ctx.regs.arg6;
-                                break;
-                            default:
-                                reg = nullptr;
-                                break;
-                            }
-                        if(reg == nullptr){
-                            return;
-                        }
-                        UnsyncRegister(*reg);
-                        file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
-                        if(!ins.address){
-                            file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", ";
-                        }
-                        else{
-                            file<<GenerateRegisterOP(ctx.regs.frameReg)<<", ";
+                else{
+                    PEStore(fr, idx, bytes, PELoad(fr, idx, bytes) + delta);
+                }
+                break;
+            }
+            case BFOpType::MOV:
+                if(!PEWritable(fr, bytes, idx)){
+                    return PEStop(st, op, "pointer outside the tape");
+                }
+                if(IsVectorWidth(op.width)){
+                    for(int b = 0; b < bytes; b++){
+                        PEStore(fr, idx + b, 1, op.val & 0xFF);
+                    }
+                }
+                else{
+                    PEStore(fr, idx, bytes, op.val);
+                }
+                break;
+            case BFOpType::OUTPUT:
+                if(!PECell(fr, 1, idx) || st.output.size() + op.count > PE_MAX_OUTPUT){
+                    return PEStop(st, op, "output");
+                }
+                st.output.insert(st.output.end(), op.count, fr.bytes[idx]);
+                if(op.count > 0){
+                    // what the write syscalls leave behind
+                    PEClobber(st.regs[TR_RAX]);
+                    PEClobber(st.regs[TR_ARG2]);
+                    PEClobber(st.regs[TR_ARG4]);
+                    PESetReg(st.regs[TR_ARG1], 8, SYS_OUT);
+                    PESetReg(st.regs[TR_ARG3], 8, 1);
+                }
+                break;
+            case BFOpType::ARGUMENT:
+                if(op.address || op.count < 1 || op.count > 6 || IsFloatWidth(op.width)){
+                    return PEStop(st, op, "argument");
+                }
+                if(!PECell(fr, bytes, idx)){
+                    return PEStop(st, op, "unknown cell");
+                }
+                PESetReg(st.regs[op.count], bytes, PELoad(fr, idx, bytes));
+                break;
+            case BFOpType::GETARG:{
+                uint8_t need = (1 << std::min(bytes, 8)) - 1;
+                if(op.address || op.count < 1 || op.count > 6 || (st.regs[op.count].known & need) != need || IsFloatWidth(op.width)){
+                    return PEStop(st, op, "input");
+                }
+                if(!PEWritable(fr, bytes, idx)){
+                    return PEStop(st, op, "pointer outside the tape");
+                }
+                PEStore(fr, idx, bytes, st.regs[op.count].val);
+                break;
+            }
+            case BFOpType::LOOP_START:
+                if(op.counted){
+                    uint64_t count = op.val;
+                    if(op.fromCell){
+                        if(!PECell(fr, bytes, idx)){
+                            return PEStop(st, op, "unknown cell");
                         }
-                        file<<'%'<<GetRegisterWidth(*reg, currentWidth)<<std::endl;
+                        count = PELoad(fr, idx, bytes);
+                    }
+                    if(count == 0){
+                        i = op.match;
                     }
                     else{
-                        if(ins.address){
-                            file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
-                            file<<GenerateRegisterOP(ctx.regs.frameReg)<<", ";
-                        }
-                        else{
-                            UnsyncRegister(ctx.regs.rax);
-                            file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
-                            file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", %"<<GetRegisterWidth(ctx.regs.rax, currentWidth)<<std::endl;
-                            file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
-                            file<<GenerateRegisterOP(ctx.regs.rax)<<", ";
-                        }
-                        unsigned int offset = ins.count - 7;
-                        if(offset > 0){
-                            file<<offset * 8;
-                        }
-                        file<<GenerateMemRegisterOP(ctx.regs.stackReg)<<std::endl;
+                        counters[i] = count;
                     }
+                    break;
                 }
-                else if(ins.type == BFInstructionType::GETARG){
-                    if(ins.count <= 6){
-                        Register* reg;
-                        switch(ins.count){
-                            case 1:
-                                reg = &ctx.regs.arg1;
-                                break;
-                            case 2:
-                                reg = &ctx.regs.arg2;
-                                break;
-                            case 3:
-                                reg = &ctx.regs.arg3;
-                                break;
-                            case 4:
-                                reg = &ctx.regs.arg4;
-                                break;
-                            case 5:
-                                reg = &ctx.regs.arg5;
-                                break;
-                            case 6:
-                                reg = &ctx.regs.arg6;
-                                break;
-                            default:
-                                reg = nullptr;
-                                break;
-                            }
-                        if(reg == nullptr){
-                            return;
-                        }
-                        file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
-                        file<<'%'<<GetRegisterWidth(*reg, currentWidth)<<", ";
-                        if(ins.address){
-                            file<<'%'<<GetRegisterWidth(ctx.regs.frameReg, currentWidth)<<std::endl;
-                        }
-                        else{
-                            file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<std::endl;
-                        }
+                if(!PECell(fr, bytes, idx)){
+                    return PEStop(st, op, "unknown cell");
+                }
+                if(IsFloatWidth(op.width) ? !PEFloatTrue(op.width, PELoad(fr, idx, bytes)) :
+                    std::all_of(fr.bytes.begin() + idx, fr.bytes.begin() + idx + bytes, [](uint8_t b){ return b == 0; })){
+                    i = op.match;
+                }
+                break;
+            case BFOpType::LOOP_END:{
+                if(op.counted){
+                    if(--counters[op.match] != 0){
+                        i = op.match;
                     }
-                    else{
-                        std::cerr<<"Accepting stack arguments isnt available currently"<<std::endl;
-                        // ugh i dont wanna
+                    break;
+                }
+                Widths loopWidth = fn.ops[op.match].width;
+                int loopBytes = GetMultiplier(loopWidth);
+                if(!PECell(fr, loopBytes, idx)){
+                    return PEStop(st, op, "unknown cell");
+                }
+                if(IsFloatWidth(loopWidth) ? PEFloatTrue(loopWidth, PELoad(fr, idx, loopBytes)) :
+                    std::any_of(fr.bytes.begin() + idx, fr.bytes.begin() + idx + loopBytes, [](uint8_t b){ return b != 0; })){
+                    i = op.match;
+                }
+                break;
+            }
+            case BFOpType::CALL:
+                if(IsFloatWidth(op.width)){
+                    // the result comes back in xmm0, which the interpreter does not model
+                    return PEStop(st, op, "call");
+                }
+                if(!PECall(st, fr, op, depth)){
+                    return false;
+                }
+                break;
+            case BFOpType::RET:
+                if(depth == 0 || IsFloatWidth(op.width)){
+                    return PEStop(st, op, "return");
+                }
+                if(st.ctx.labels[op.target].type != Keyword::Void){
+                    if(!PECell(fr, bytes, idx)){
+                        return PEStop(st, op, "unknown return value");
                     }
+                    PESetReg(st.regs[TR_RAX], bytes, PELoad(fr, idx, bytes));
+                }
+                return true;
+            case BFOpType::WRITE:{
+                long long size = (long long)op.count * bytes;
+                if(size == 0){
+                    break;
+                }
+                if(!PECell(fr, size, idx) || st.output.size() + size > PE_MAX_OUTPUT){
+                    return PEStop(st, op, "output");
+                }
+                st.output.insert(st.output.end(), fr.bytes.begin() + idx, fr.bytes.begin() + idx + size);
+                PEClobber(st.regs[TR_RAX]);
+                PEClobber(st.regs[TR_ARG2]);
+                PEClobber(st.regs[TR_ARG3]);
+                PEClobber(st.regs[TR_ARG4]);
+                PESetReg(st.regs[TR_ARG1], 8, SYS_OUT);
+                break;
+            }
+            case BFOpType::READ:
+                if(op.count == 0){
+                    break;
+                }
+                return PEStop(st, op, "input");
+            case BFOpType::BIN:
+                // the data's address is only known once the program is linked
+                return PEStop(st, op, "?bin");
+            case BFOpType::SAVE:
+            case BFOpType::RESTORE:
+                // the register has to hold the pointer when the rest of main runs
+                return PEStop(st, op, "checkpoint");
+            default:
+                return PEStop(st, op, OpTypeName(op.type));
+        }
+    }
+    return true;
+}
+
+// runs main until it needs the run time, then swaps everything it ran for one preload
+void PartialEvaluate(ParsedContext& ctx, std::vector<BFFunction>& funcs){
+    if(PARTIAL_EVAL == 0){
+        return;
+    }
+    PEState st(ctx, funcs);
+    BFFunction* main = nullptr;
+    for(size_t f = 0; f < funcs.size(); f++){
+        Label& lbl = ctx.labels[funcs[f].label];
+        st.byName.emplace(lbl.Name, f);
+        if(lbl.Name == "main"){
+            main = &funcs[f];
+        }
+    }
+    if(main == nullptr || !main->structured){
+        return;
+    }
+
+    // only whole top level ops count, a run that stops halfway through one is rolled back
+    PEFrame fr;
+    size_t stop = 0;
+    while(stop < main->ops.size()){
+        BFOp& op = main->ops[stop];
+        size_t next = op.type == BFOpType::LOOP_START ? op.match + 1 : stop + 1;
+        // single ops check everything before they change anything, loops and calls need a copy
+        bool big = op.type == BFOpType::LOOP_START || op.type == BFOpType::CALL;
+        std::vector<uint8_t> bytes, known;
+        long long ptr = fr.ptr;
+        if(big){
+            bytes = fr.bytes;
+            known = fr.known;
+        }
+        std::vector<PEReg> regs = st.regs;
+        size_t written = st.output.size();
+        if(!PERun(st, fr, *main, stop, next, 0)){
+            if(big){
+                fr.bytes.swap(bytes);
+                fr.known.swap(known);
+            }
+            fr.ptr = ptr;
+            st.regs = regs;
+            st.output.resize(written);
+            break;
+        }
+        stop = next;
+    }
+    if(stop == 0){
+        return;
+    }
+
+    PartialEval& pe = ctx.partial;
+    pe.done = true;
+    pe.steps = st.steps;
+    pe.stop = stop < main->ops.size() ? st.stop : "end of main";
+    pe.line = stop < main->ops.size() && st.stopPos < ctx.tokens.size() ? ctx.tokens[st.stopPos].line : 0;
+    pe.output = st.output;
+    pe.regs = st.regs;
+    long long first = -1, last = -1;
+    for(long long b = 0; b < (long long)fr.known.size(); b++){
+        if(fr.known[b]){
+            first = first < 0 ? b : first;
+            last = b;
+        }
+    }
+    if(first >= 0){
+        // never written bytes in between were garbage, zero is as good
+        pe.lo = first - BASE_OFFSET;
+        pe.tape.assign(fr.bytes.begin() + first, fr.bytes.begin() + last + 1);
+    }
+
+    std::vector<BFOp> ops;
+    BFOp preload(BFOpType::PRELOAD, Widths::Byte, main->ops[0].pos);
+    preload.val = pe.lo;
+    preload.count = pe.tape.size();
+    ops.push_back(preload);
+    if(fr.ptr != 0){
+        BFOp move(fr.ptr > 0 ? BFOpType::RIGHT : BFOpType::LEFT, Widths::Byte, main->ops[0].pos);
+        move.count = fr.ptr > 0 ? fr.ptr : -fr.ptr;
+        ops.push_back(move);
+    }
+    ops.insert(ops.end(), main->ops.begin() + stop, main->ops.end());
+    main->ops = ops;
+    MatchLoops(*main);
+}
+
+// offset of the last output in a balanced loop, which is where the buffer register points on the back edge
+long long LastOutputOffset(BFFunction& fn, size_t start){
+    long long net = 0, last = 0;
+    for(size_t i = start + 1; i < fn.ops[start].match; i++){
+        BFOp& op = fn.ops[i];
+        if(op.type == BFOpType::RIGHT){
+            net += (long long)op.count * GetMultiplier(op.width);
+        }
+        else if(op.type == BFOpType::LEFT){
+            net -= (long long)op.count * GetMultiplier(op.width);
+        }
+        else if(op.type == BFOpType::OUTPUT){
+            last = net;
+        }
+        else if(op.type == BFOpType::INLINE_START){
+            i = op.match;
+        }
+    }
+    return last;
+}
+
+// whether the tape pointer is back where it started after every iteration
+bool LoopBalanced(BFFunction& fn, size_t start){
+    long long net = 0;
+    for(size_t i = start + 1; i < fn.ops[start].match; i++){
+        BFOp& op = fn.ops[i];
+        if(op.type == BFOpType::RIGHT){
+            net += (long long)op.count * GetMultiplier(op.width);
+        }
+        else if(op.type == BFOpType::LEFT){
+            net -= (long long)op.count * GetMultiplier(op.width);
+        }
+        else if((op.type == BFOpType::GETARG && op.address) || (op.type == BFOpType::BIN && op.count == 0) ||
+            op.type == BFOpType::SCAN || op.type == BFOpType::RESTORE){
+            return false;
+        }
+        else if(op.type == BFOpType::LOOP_START){
+            if(!LoopBalanced(fn, i)){
+                return false;
+            }
+            i = op.match;
+        }
+        else if(op.type == BFOpType::INLINE_START){
+            // the caller's pointer is restored when the inlined body ends
+            i = op.match;
+        }
+    }
+    return net == 0;
+}
+
+// bytes a cell access at the given width touches, used by the extent analysis
+inline long long CellBytes(BFOp& op){
+    switch(op.type){
+        case BFOpType::OUTPUT:
+            return 1;
+        case BFOpType::LEFT:
+        case BFOpType::RIGHT:
+        case BFOpType::INLINE_START:
+        case BFOpType::INLINE_END:
+        case BFOpType::SPAWN:
+        case BFOpType::SAVE:
+        case BFOpType::RESTORE:
+            return 0;
+        case BFOpType::ARGUMENT:
+        case BFOpType::GETARG:
+            return op.address ? 0 : GetMultiplier(op.width);
+        case BFOpType::WRITE:
+        case BFOpType::READ:
+            return (long long)op.count * GetMultiplier(op.width);
+        default:
+            return GetMultiplier(op.width);
+    }
+}
+
+// smallest and one past the largest tape byte a label touches relative to its starting cell,
+// false when the pointer movement is not static
+bool TapeExtent(BFFunction& fn, long long& lo, long long& hi){
+    if(!fn.structured){
+        return false;
+    }
+    long long net = 0;
+    lo = 0;
+    hi = 0;
+    for(size_t i = 0; i < fn.ops.size(); i++){
+        BFOp& op = fn.ops[i];
+        if(op.type == BFOpType::RIGHT){
+            net += (long long)op.count * GetMultiplier(op.width);
+        }
+        else if(op.type == BFOpType::LEFT){
+            net -= (long long)op.count * GetMultiplier(op.width);
+        }
+        else if((op.type == BFOpType::GETARG && op.address) || (op.type == BFOpType::BIN && op.count == 0) ||
+            op.type == BFOpType::SCAN || op.type == BFOpType::RESTORE){
+            return false;
+        }
+        else if(op.type == BFOpType::LOOP_START && !LoopBalanced(fn, i)){
+            return false;
+        }
+        else if(op.type == BFOpType::INLINE_START){
+            // inlined bodies live in their own slice of the frame
+            i = op.match - 1;
+            continue;
+        }
+        else if(op.type == BFOpType::PRELOAD){
+            if(op.count > 0){
+                lo = std::min(lo, net + op.val);
+                hi = std::max(hi, net + op.val + (long long)op.count);
+            }
+            continue;
+        }
+        long long bytes = CellBytes(op);
+        if(bytes > 0){
+            lo = std::min(lo, net);
+            hi = std::max(hi, net + bytes);
+        }
+    }
+    return true;
+}
+
+// labels that can reach themselves through ?call
+std::vector<bool> FindRecursive(std::vector<BFFunction>& funcs, std::unordered_map<std::string_view, size_t>& byName){
+    size_t n = funcs.size();
+    std::vector<std::vector<size_t>> edges(n);
+    for(size_t f = 0; f < n; f++){
+        for(BFOp& op : funcs[f].ops){
+            if(op.type != BFOpType::CALL) continue;
+            auto it = byName.find(op.name);
+            if(it != byName.end()){
+                edges[f].push_back(it->second);
+            }
+        }
+    }
+    std::vector<bool> recursive(n, false);
+    for(size_t f = 0; f < n; f++){
+        std::vector<bool> seen(n, false);
+        std::vector<size_t> work = edges[f];
+        while(!work.empty() && !recursive[f]){
+            size_t g = work.back();
+            work.pop_back();
+            if(g == f){
+                recursive[f] = true;
+            }
+            else if(!seen[g]){
+                seen[g] = true;
+                work.insert(work.end(), edges[g].begin(), edges[g].end());
+            }
+        }
+    }
+    return recursive;
+}
+
+bool CanInline(ParsedContext& ctx, BFFunction& callee, bool recursive){
+    size_t threshold = INLINE_THRESHOLD;
+    if(ctx.profile.loaded){
+        // labels that never ran stay out of line, hot ones may grow their callers more
+        if(ctx.profile.labels[callee.label] == 0){
+            return false;
+        }
+        if(callee.hot){
+            threshold *= 4;
+        }
+    }
+    if(recursive || !callee.structured || callee.ops.size() > threshold){
+        return false;
+    }
+    for(BFOp& op : callee.ops){
+        // stack arguments would land in the caller's tape, a preload's data exists once,
+        // checkpoint names are local to their label
+        if((op.type == BFOpType::ARGUMENT && op.count > 6) || op.type == BFOpType::PRELOAD || op.type == BFOpType::SAVE){
+            return false;
+        }
+    }
+    long long lo, hi;
+    return TapeExtent(callee, lo, hi);
+}
+
+// splices small non-recursive labels into their callers, the callee tape gets remapped
+// into a slice above the caller's tape that also holds the caller's pointer
+void InlineCalls(ParsedContext& ctx, std::vector<BFFunction>& funcs){
+    // the inline slice sits on the machine stack, outside the guarded tapes,
+    // and a profiling build counts every call so the profile sees each label on its own
+    if(INLINE_THRESHOLD == 0 || CHECKED_TAPE || PROFILE_GENERATE){
+        return;
+    }
+    std::unordered_map<std::string_view, size_t> byName;
+    for(size_t f = 0; f < funcs.size(); f++){
+        byName.emplace(ctx.labels[funcs[f].label].Name, f);
+    }
+    std::vector<bool> recursive = FindRecursive(funcs, byName);
+
+    // bodies are copied from the originals so inlining never nests
+    std::vector<std::vector<BFOp>> bodies;
+    std::vector<int> counters;
+    for(BFFunction& fn : funcs){
+        bodies.push_back(fn.ops);
+        counters.push_back(CountedDepth(fn.ops));
+    }
+
+    size_t nextLoop = ctx.done_loops.size();
+    size_t nextInline = 0;
+    for(size_t f = 0; f < funcs.size(); f++){
+        BFFunction& fn = funcs[f];
+        if(ctx.profile.loaded && fn.weight == 0){
+            continue;
+        }
+        Label& caller = ctx.labels[fn.label];
+        std::vector<BFOp> out;
+        bool inlined = false;
+        int depth = 0; // ?times loops around the call, the callee's own counters go on top
+        int checkpoints = CheckpointNames(bodies[f]).size();
+        for(BFOp& op : bodies[f]){
+            if(op.counted){
+                depth += op.type == BFOpType::LOOP_START ? 1 : -1;
+            }
+            auto it = op.type == BFOpType::CALL ? byName.find(op.name) : byName.end();
+            if(it == byName.end() || it->second == f || !CanInline(ctx, funcs[it->second], recursive[it->second]) ||
+                depth + counters[it->second] + checkpoints > MAX_COUNTERS){
+                out.push_back(op);
+                continue;
+            }
+            BFFunction& callee = funcs[it->second];
+            long long lo, hi;
+            TapeExtent(callee, lo, hi);
+            size_t region = (8 + (hi - lo) + 15) & ~(size_t)15;
+            caller.extraAlloc = std::max(caller.extraAlloc, region);
+
+            size_t id = nextInline++;
+            BFOp start(BFOpType::INLINE_START, op.width, op.pos);
+            start.target = id;
+            start.val = 8 - lo;
+            start.name = op.name;
+            out.push_back(start);
+
+            std::unordered_map<size_t, size_t> loopIds;
+            for(BFOp body : bodies[it->second]){
+                if(body.type == BFOpType::LOOP_START || body.type == BFOpType::LOOP_END){
+                    auto id = loopIds.find(body.target);
+                    if(id == loopIds.end()){
+                        id = loopIds.emplace(body.target, nextLoop++).first;
+                    }
+                    body.target = id->second;
+                }
+                else if(body.type == BFOpType::RET){
+                    body.type = BFOpType::INLINE_RET;
+                    body.val = body.target;
+                    body.target = id;
+                }
+                out.push_back(body);
+            }
+
+            BFOp end(BFOpType::INLINE_END, op.width, op.pos);
+            end.target = id;
+            end.name = op.name;
+            out.push_back(end);
+            inlined = true;
+        }
+        if(inlined){
+            fn.ops = out;
+            MatchLoops(fn);
+        }
+    }
+}
+
+// labels main reaches through ?call, ?spawn and tail calls, the rest is dropped unless --export
+// keeps it. a source without main is a library and keeps everything, so does one where a loop
+// crosses labels since the other label's code is jumped into directly
+void MarkLive(ParsedContext& ctx, std::vector<BFFunction>& funcs){
+    std::unordered_map<std::string_view, size_t> byName;
+    for(size_t f = 0; f < funcs.size(); f++){
+        byName.emplace(ctx.labels[funcs[f].label].Name, f);
+        if(!funcs[f].structured){
+            return;
+        }
+    }
+    auto main = byName.find("main");
+    if(main == byName.end()){
+        return;
+    }
+    std::vector<size_t> work = {main->second};
+    for(std::string& name : EXPORTS){
+        auto it = byName.find(name);
+        if(it == byName.end()){
+            Diag()<<"bf++: warning: --export "<<name<<" names no label"<<std::endl;
+            continue;
+        }
+        work.push_back(it->second);
+    }
+    for(BFFunction& fn : funcs){
+        fn.live = false;
+    }
+    while(!work.empty()){
+        size_t f = work.back();
+        work.pop_back();
+        if(funcs[f].live){
+            continue;
+        }
+        funcs[f].live = true;
+        for(BFOp& op : funcs[f].ops){
+            if(op.type != BFOpType::CALL && op.type != BFOpType::SPAWN && op.type != BFOpType::TAIL_CALL){
+                continue;
+            }
+            auto it = byName.find(op.name);
+            if(it != byName.end()){
+                work.push_back(it->second);
+            }
+        }
+    }
+}
+
+// whether two labels come out as the same instructions, loop and inline ids only name local labels
+bool SameBody(ParsedContext& ctx, BFFunction& a, BFFunction& b){
+    Label& la = ctx.labels[a.label];
+    Label& lb = ctx.labels[b.label];
+    if(!a.structured || !b.structured || a.ops.size() != b.ops.size() || la.type != lb.type ||
+        la.frameAlloc != lb.frameAlloc || la.extraAlloc != lb.extraAlloc || la.savedRegs != lb.savedRegs){
+        return false;
+    }
+    for(size_t i = 0; i < a.ops.size(); i++){
+        BFOp& x = a.ops[i];
+        BFOp& y = b.ops[i];
+        if(x.type != y.type || x.width != y.width || x.count != y.count || x.address != y.address ||
+            x.val != y.val || x.match != y.match || x.name != y.name || x.hoist != y.hoist ||
+            x.hoistFrame != y.hoistFrame || x.counted != y.counted || x.fromCell != y.fromCell || x.counter != y.counter){
+            return false;
+        }
+        switch(x.type){
+            case BFOpType::LOOP_START:
+                if(IsColdLoop(ctx, a, x) != IsColdLoop(ctx, b, y)){
+                    return false;
+                }
+                break;
+            case BFOpType::LOOP_END:
+            case BFOpType::INLINE_START:
+            case BFOpType::INLINE_RET:
+            case BFOpType::INLINE_END:
+            case BFOpType::RET:
+                break;
+            default:
+                if(x.target != y.target){
+                    return false;
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+// identical bodies are emitted once, the later labels in the layout become symbols on the first.
+// line marks, .loc and profile counters belong to one label, those builds keep every body
+void FoldIdentical(ParsedContext& ctx, std::vector<BFFunction>& funcs, std::vector<size_t>& order){
+    if(DEBUG_INFO || CHECKED_TAPE || PROFILE_GENERATE){
+        return;
+    }
+    for(size_t i = 0; i < order.size(); i++){
+        BFFunction& fn = funcs[order[i]];
+        if(!fn.live || fn.folded){
+            continue;
+        }
+        for(size_t j = i + 1; j < order.size(); j++){
+            BFFunction& other = funcs[order[j]];
+            if(other.live && !other.folded && SameBody(ctx, fn, other)){
+                other.folded = true;
+                fn.aliases.push_back(other.label);
+            }
+        }
+    }
+}
+
+// whether returning the callee's rax as is gives the same value as storing it into the cell
+// at the call width and reading it back at the return width
+inline bool SameReturnValue(Label& lbl, Widths callWidth, Widths retWidth){
+    if(lbl.type == Keyword::Void){
+        return true;
+    }
+    // float values come back in xmm0, integer ones in rax
+    if(IsFloatWidth(callWidth) || IsFloatWidth(retWidth)){
+        return callWidth == retWidth;
+    }
+    // 32 bit loads zero the upper half, the narrower ones keep rax's upper bytes
+    if(retWidth == Widths::Dword){
+        return false;
+    }
+    return GetMultiplier(callWidth) >= GetMultiplier(retWidth);
+}
+
+// '?call f' directly followed by '!' tears the frame down and jumps to f instead
+void LowerTailCalls(ParsedContext& ctx, BFFunction& fn){
+    if(!fn.structured){
+        return;
+    }
+    for(BFOp& op : fn.ops){
+        // outgoing stack arguments and cell addresses point into the frame that is about to go away
+        if(op.type == BFOpType::ARGUMENT && (op.count > 6 || op.address)){
+            return;
+        }
+    }
+    Label& lbl = ctx.labels[fn.label];
+    std::vector<BFOp> out;
+    bool lowered = false;
+    for(size_t i = 0; i < fn.ops.size(); i++){
+        BFOp& op = fn.ops[i];
+        if(op.type == BFOpType::CALL && i + 1 < fn.ops.size()){
+            BFOp& next = fn.ops[i + 1];
+            if(next.type == BFOpType::RET && SameReturnValue(lbl, op.width, next.width)){
+                BFOp tail = op;
+                tail.type = BFOpType::TAIL_CALL;
+                out.push_back(tail);
+                lowered = true;
+                i++;
+                continue;
+            }
+        }
+        out.push_back(op);
+    }
+    if(lowered){
+        fn.ops = out;
+        MatchLoops(fn);
+    }
+}
+
+// '[>]', '[<<]' and friends only look for the next zero cell, with a power of two stride
+// that whole cells fit into the search runs a vector at a time
+void LowerScans(ParsedContext& ctx, BFFunction& fn){
+    // a fault inside the shared routine would lose the source line
+    if(!fn.structured || CHECKED_TAPE){
+        return;
+    }
+    for(BFOp& op : fn.ops){
+        // the routines clobber xmm0, which may be holding a float argument or result
+        if(IsFloatWidth(op.width)){
+            return;
+        }
+    }
+    std::vector<BFOp> out;
+    bool lowered = false;
+    for(size_t i = 0; i < fn.ops.size(); i++){
+        BFOp& op = fn.ops[i];
+        if(op.type == BFOpType::LOOP_START && !op.counted && op.match == i + 2 &&
+            (fn.ops[i + 1].type == BFOpType::LEFT || fn.ops[i + 1].type == BFOpType::RIGHT)){
+            BFOp& move = fn.ops[i + 1];
+            int width = GetMultiplier(op.width);
+            long long stride = (long long)move.count * GetMultiplier(move.width);
+            if(width <= 8 && stride <= 16 && (stride & (stride - 1)) == 0 && stride % width == 0){
+                ScanRoutine routine(move.type == BFOpType::LEFT, width, stride);
+                size_t id = 0;
+                while(id < ctx.scans.size() && ctx.scans[id].Name() != routine.Name()){
+                    id++;
+                }
+                if(id == ctx.scans.size()){
+                    ctx.scans.push_back(routine);
+                }
+                BFOp scan(BFOpType::SCAN, op.width, op.pos);
+                scan.target = id;
+                scan.count = move.count;
+                out.push_back(scan);
+                lowered = true;
+                i += 2;
+                continue;
+            }
+        }
+        out.push_back(op);
+    }
+    if(lowered){
+        fn.ops = out;
+        MatchLoops(fn);
+    }
+}
+
+// a ?times body short enough to copy, anything that places labels of its own stays a loop
+inline bool IsUnrollable(BFFunction& fn, size_t start){
+    size_t end = fn.ops[start].match;
+    if(end - start - 1 > UNROLL_MAX_OPS){
+        return false;
+    }
+    for(size_t i = start + 1; i < end; i++){
+        switch(fn.ops[i].type){
+            case BFOpType::LOOP_START:
+            case BFOpType::INLINE_START:
+            case BFOpType::PRELOAD:
+                return false;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+// short ?times loops with an immediate count run UNROLL copies of their body per iteration,
+// the iterations that do not divide evenly become straight copies in front
+void UnrollCounted(BFFunction& fn){
+    // a profiling build counts the iterations the source wrote
+    if(UNROLL < 2 || !fn.structured || PROFILE_GENERATE){
+        return;
+    }
+    std::vector<BFOp> out;
+    bool unrolled = false;
+    for(size_t i = 0; i < fn.ops.size(); i++){
+        BFOp& op = fn.ops[i];
+        if(op.type != BFOpType::LOOP_START || !op.counted || op.fromCell || !IsUnrollable(fn, i)){
+            out.push_back(op);
+            continue;
+        }
+        auto first = fn.ops.begin() + i + 1, last = fn.ops.begin() + op.match;
+        unsigned long long count = op.val;
+        unsigned long long iterations = count / UNROLL;
+        size_t copies = count % UNROLL + (iterations > 0 ? UNROLL : 0);
+        if((op.match - i - 1) * copies > UNROLL_MAX_GROWTH){
+            out.push_back(op);
+            continue;
+        }
+        for(unsigned long long c = 0; c < count % UNROLL; c++){
+            out.insert(out.end(), first, last);
+        }
+        if(iterations > 1){
+            BFOp start = op;
+            start.val = iterations;
+            out.push_back(start);
+        }
+        if(iterations > 0){
+            for(unsigned int c = 0; c < UNROLL; c++){
+                out.insert(out.end(), first, last);
+            }
+        }
+        if(iterations > 1){
+            out.push_back(fn.ops[op.match]);
+        }
+        i = op.match;
+        unrolled = true;
+    }
+    if(unrolled){
+        fn.ops = out;
+        MatchLoops(fn);
+    }
+}
+
+// every ?times nesting level gets the next counter register and every checkpoint one above the
+// deepest level, the label saves the ones it uses
+void AllocateCounters(BFFunction& fn, Label& lbl){
+    unsigned int depth = 0;
+    for(BFOp& op : fn.ops){
+        if(op.counted && op.type == BFOpType::LOOP_START){
+            op.counter = depth++;
+            lbl.savedRegs = std::max(lbl.savedRegs, depth);
+        }
+        else if(op.counted && op.type == BFOpType::LOOP_END){
+            op.counter = --depth;
+        }
+    }
+    std::vector<std::string_view> names = CheckpointNames(fn.ops);
+    for(BFOp& op : fn.ops){
+        if(op.type == BFOpType::SAVE || op.type == BFOpType::RESTORE){
+            op.counter = lbl.savedRegs + (std::find(names.begin(), names.end(), op.name) - names.begin());
+        }
+    }
+    lbl.savedRegs += names.size();
+}
+
+// loops that output but never touch the syscall argument registers get them loaded once up front
+void HoistSyscallSetup(BFFunction& fn){
+    if(!fn.structured){
+        return;
+    }
+    for(size_t i = 0; i < fn.ops.size(); i++){
+        BFOp& loop = fn.ops[i];
+        if(loop.type != BFOpType::LOOP_START){
+            continue;
+        }
+        bool output = false;
+        uint8_t clobbered = 0;
+        for(size_t j = i + 1; j < loop.match; j++){
+            BFOp& op = fn.ops[j];
+            if(op.type == BFOpType::OUTPUT){
+                output = true;
+            }
+            else if(op.type == BFOpType::CALL){
+                clobbered |= op.clobbers;
+            }
+            else if(op.type == BFOpType::TAIL_CALL || op.type == BFOpType::INLINE_START ||
+                    op.type == BFOpType::SPAWN || op.type == BFOpType::JOIN){
+                clobbered = 0xFF;
+            }
+            else if((op.type == BFOpType::ARGUMENT || op.type == BFOpType::BIN) && op.count <= 6){
+                clobbered |= 1 << op.count;
+            }
+            else if(op.type == BFOpType::WRITE || op.type == BFOpType::READ){
+                clobbered |= 1 << TR_ARG1 | 1 << TR_ARG2 | 1 << TR_ARG3;
+            }
+        }
+        if(!output){
+            continue;
+        }
+        if(!(clobbered & (1 << TR_ARG1))){
+            loop.hoist |= 1 << TR_ARG1;
+        }
+        if(!(clobbered & (1 << TR_ARG3))){
+            loop.hoist |= 1 << TR_ARG3;
+        }
+        if(!(clobbered & (1 << TR_ARG2)) && LoopBalanced(fn, i)){
+            loop.hoist |= 1 << TR_ARG2;
+            loop.hoistFrame = LastOutputOffset(fn, i);
+        }
+    }
+}
+
+inline RegisterState MeetStates(const RegisterState& a, const RegisterState& b){
+    if(!a.reachable) return b;
+    if(!b.reachable) return a;
+    RegisterState out = a;
+    for(int r = 0; r < TR_COUNT; r++){
+        if(a.regs[r] != b.regs[r]){
+            out.regs[r] = RegValue();
+        }
+    }
+    return out;
+}
+
+inline void ForgetRegisters(RegisterState& st){
+    for(int r = 0; r < TR_COUNT; r++){
+        st.regs[r] = RegValue();
+    }
+}
+
+// the tape pointer moved by bytes, registers pointing into the tape keep their address
+inline void MoveFrame(RegisterState& st, long long bytes){
+    for(int r = 0; r < TR_COUNT; r++){
+        if(st.regs[r].kind == RegValueKind::Frame){
+            st.regs[r].value -= bytes;
+        }
+    }
+}
+
+inline void ForgetFrame(RegisterState& st){
+    for(int r = 0; r < TR_COUNT; r++){
+        if(st.regs[r].kind == RegValueKind::Frame){
+            st.regs[r] = RegValue();
+        }
+    }
+}
+
+inline RegValue HoistedValue(BFOp& op, TrackedRegister reg){
+    if(reg == TR_ARG2){
+        return RegValue(RegValueKind::Frame, op.hoistFrame);
+    }
+    return OutputSetup(reg);
+}
+
+inline void ApplyHoist(RegisterState& st, BFOp& op){
+    for(TrackedRegister reg : OutputRegisters){
+        if(op.hoist & (1 << reg)){
+            st.regs[reg] = HoistedValue(op, reg);
+        }
+    }
+}
+
+void ApplyOp(RegisterState& st, BFOp& op, ParsedContext& ctx){
+    switch(op.type){
+        case BFOpType::LEFT:
+            MoveFrame(st, -(long long)op.count * GetMultiplier(op.width));
+            break;
+        case BFOpType::RIGHT:
+            MoveFrame(st, (long long)op.count * GetMultiplier(op.width));
+            break;
+        case BFOpType::OUTPUT:
+            if(op.count > 0){
+                for(TrackedRegister reg : OutputRegisters){
+                    st.regs[reg] = OutputSetup(reg);
+                }
+                // syscall returns into rax and clobbers rcx and r11
+                st.regs[TR_RAX] = RegValue();
+                st.regs[TR_ARG4] = RegValue();
+            }
+            break;
+        case BFOpType::ARGUMENT:
+            if(IsFloatWidth(op.width)){
+                // float arguments go into xmm registers
+                break;
+            }
+            if(op.count <= 6){
+                if(op.address && op.width == Widths::Qword){
+                    st.regs[op.count] = RegValue(RegValueKind::Frame, 0);
+                }
+                else{
+                    st.regs[op.count] = RegValue();
+                }
+            }
+            else if(!op.address){
+                st.regs[TR_RAX] = RegValue();
+            }
+            break;
+        case BFOpType::GETARG:
+            if(op.address && op.count <= 6){
+                RegValue src = st.regs[op.count];
+                if(op.width == Widths::Qword && src.kind == RegValueKind::Frame){
+                    MoveFrame(st, src.value);
+                }
+                else if(op.width == Widths::Qword){
+                    ForgetFrame(st);
+                    st.regs[op.count] = RegValue(RegValueKind::Frame, 0);
+                }
+                else{
+                    ForgetFrame(st);
+                }
+            }
+            break;
+        case BFOpType::CALL:
+            for(int r = 0; r < TR_COUNT; r++){
+                if(op.clobbers & (1 << r)){
+                    st.regs[r] = RegValue();
+                }
+            }
+            break;
+        case BFOpType::SPAWN:
+        case BFOpType::JOIN:
+        case BFOpType::PRELOAD:
+            ForgetRegisters(st);
+            break;
+        case BFOpType::RET:
+        case BFOpType::INLINE_RET:
+        case BFOpType::TAIL_CALL:
+            st.reachable = false;
+            break;
+        case BFOpType::INLINE_START:
+        case BFOpType::RESTORE:
+            ForgetFrame(st);
+            break;
+        case BFOpType::WRITE:
+        case BFOpType::READ:
+            if(op.count > 0){
+                // the transfer loop leaves rsi and rdx somewhere past the cells
+                st.regs[TR_RAX] = RegValue();
+                st.regs[TR_ARG1] = RegValue(RegValueKind::Constant, op.type == BFOpType::WRITE ? SYS_OUT : SYS_IN);
+                st.regs[TR_ARG2] = RegValue();
+                st.regs[TR_ARG3] = RegValue();
+                st.regs[TR_ARG4] = RegValue();
+            }
+            break;
+        case BFOpType::BIN:
+            if(op.count == 0){
+                ForgetFrame(st);
+            }
+            else{
+                st.regs[op.count] = RegValue();
+            }
+            break;
+        case BFOpType::SCAN:
+            // the routines only clobber rax, r10 and r11 of the integer registers
+            ForgetFrame(st);
+            st.regs[TR_RAX] = RegValue();
+            break;
+        case BFOpType::INLINE_END:
+            // joined by every inlined return, the caller's pointer comes back from the frame
+            st.reachable = true;
+            ForgetRegisters(st);
+            break;
+        case BFOpType::LOOP_START:
+            ApplyHoist(st, op);
+            break;
+        default:
+            break;
+    }
+    (void)ctx;
+}
+
+// tracked registers one op writes, read off ApplyOp so the two cannot disagree
+uint8_t OpClobbers(ParsedContext& ctx, BFOp& op){
+    RegisterState st;
+    st.reachable = true;
+    for(int r = 0; r < TR_COUNT; r++){
+        st.regs[r] = RegValue(RegValueKind::Constant, INT64_MIN + r);
+    }
+    RegisterState before = st;
+    ApplyOp(st, op, ctx);
+    uint8_t out = 0;
+    for(int r = 0; r < TR_COUNT; r++){
+        if(st.regs[r] != before.regs[r]){
+            out |= 1 << r;
+        }
+    }
+    return out;
+}
+
+// what a call of each label can change: rax for the return value, the registers its own ops write
+// and whatever its internal callees change. externs follow SysV and may change every caller-saved
+// register, which is all of the tracked ones. the sets go onto the ?call ops for AnalyzeRegisters
+void ComputeClobbers(ParsedContext& ctx, std::vector<BFFunction>& funcs){
+    std::unordered_map<std::string_view, size_t> byName;
+    for(size_t f = 0; f < funcs.size(); f++){
+        byName.emplace(ctx.labels[funcs[f].label].Name, f);
+        if(!funcs[f].structured){
+            // loops jump between labels, a call can end up running any of them
+            return;
+        }
+    }
+    const uint8_t all = (1 << TR_COUNT) - 1;
+    for(BFFunction& fn : funcs){
+        fn.clobbers = 1 << TR_RAX;
+        for(BFOp& op : fn.ops){
+            if(op.type == BFOpType::CALL || op.type == BFOpType::TAIL_CALL){
+                if(byName.find(op.name) == byName.end()){
+                    fn.clobbers = all;
+                }
+            }
+            else if(op.type != BFOpType::INLINE_END){
+                // the join after an inlined body forgets what it knew, it writes nothing
+                fn.clobbers |= OpClobbers(ctx, op);
+            }
+        }
+    }
+    bool changed = true;
+    while(changed){
+        changed = false;
+        for(BFFunction& fn : funcs){
+            for(BFOp& op : fn.ops){
+                if(op.type != BFOpType::CALL && op.type != BFOpType::TAIL_CALL){
+                    continue;
+                }
+                auto it = byName.find(op.name);
+                if(it != byName.end() && (fn.clobbers | funcs[it->second].clobbers) != fn.clobbers){
+                    fn.clobbers |= funcs[it->second].clobbers;
+                    changed = true;
+                }
+            }
+        }
+    }
+    for(BFFunction& fn : funcs){
+        for(BFOp& op : fn.ops){
+            if(op.type == BFOpType::CALL){
+                auto it = byName.find(op.name);
+                op.clobbers = it == byName.end() ? all : funcs[it->second].clobbers;
+            }
+        }
+    }
+}
+
+// forward must-analysis over the loop CFG, passes repeat until the loop heads settle
+void AnalyzeRegisters(ParsedContext& ctx, BFFunction& fn){
+    size_t len = fn.ops.size();
+    RegisterState entry;
+    entry.reachable = true;
+
+    fn.regIn.assign(len, entry);
+    if(!fn.structured){
+        return;
+    }
+    HoistSyscallSetup(fn);
+
+    // head holds the state at a loop test, back the state flowing along the back edge
+    std::vector<RegisterState> head(len), back(len);
+    bool changed = true;
+    while(changed){
+        changed = false;
+        RegisterState cur = entry;
+        for(size_t i = 0; i < len; i++){
+            BFOp& op = fn.ops[i];
+            if(fn.regIn[i] != cur){
+                fn.regIn[i] = cur;
+                changed = true;
+            }
+            if(op.type == BFOpType::LOOP_START){
+                ApplyHoist(cur, op);
+                RegisterState h = MeetStates(cur, back[op.match]);
+                if(head[i] != h){
+                    head[i] = h;
+                    changed = true;
+                }
+                cur = h;
+            }
+            else if(op.type == BFOpType::LOOP_END){
+                if(back[i] != cur){
+                    back[i] = cur;
+                    changed = true;
+                }
+                cur = head[op.match];
+            }
+            else{
+                ApplyOp(cur, op, ctx);
+            }
+        }
+    }
+}
+
+// sizes the tape reservation from the label's extent, the global size stays for anything
+// the pointer can leave statically or that hands out its tape address
+void SizeFrame(BFFunction& fn, Label& lbl){
+    if(CHECKED_TAPE){
+        // the tape lives in a runtime slot, the stack only holds outgoing stack arguments
+        long long args = 0;
+        for(BFOp& op : fn.ops){
+            if(op.type == BFOpType::ARGUMENT && op.count > 6){
+                args = std::max(args, (long long)(op.count - 6) * 8);
+            }
+        }
+        lbl.frameAlloc = (args + 15) & ~15LL;
+        return;
+    }
+    lbl.frameAlloc = ALLOCATE;
+    long long lo, hi;
+    if(!TapeExtent(fn, lo, hi) || lo < -BASE_OFFSET){
+        return;
+    }
+    long long need = BASE_OFFSET + hi;
+    for(BFOp& op : fn.ops){
+        if(op.type == BFOpType::ARGUMENT && op.address){
+            return;
+        }
+        if(op.type == BFOpType::ARGUMENT && op.count > 6){
+            // outgoing stack arguments sit at the bottom of the reservation
+            need = std::max(need, (long long)(op.count - 6) * 8);
+        }
+    }
+    lbl.frameAlloc = (need + 15) & ~15LL;
+    lbl.frameBounded = true;
+}
+
+void PrintLayoutStats(ParsedContext& ctx, std::vector<BFFunction>& funcs, std::vector<size_t>& order){
+    Report()<<"profile layout:"<<std::endl;
+    for(size_t f : order){
+        BFFunction& fn = funcs[f];
+        Report()<<'\t'<<ctx.labels[fn.label]<<": weight "<<fn.weight;
+        if(fn.weight == 0){
+            Report()<<" (cold)";
+        }
+        else if(fn.hot){
+            Report()<<" (hot)";
+        }
+        Report()<<std::endl;
+    }
+}
+
+void PrintPartialStats(ParsedContext& ctx){
+    PartialEval& pe = ctx.partial;
+    Report()<<"partial evaluation: "<<pe.steps<<" ops of main ran at compile time, stopped at "<<pe.stop;
+    if(pe.line > 0){
+        Report()<<" on line "<<pe.line;
+    }
+    Report()<<", preloads "<<pe.tape.size()<<" tape bytes and "<<pe.output.size()<<" output bytes"<<std::endl;
+}
+
+void PrintSelectionStats(ParsedContext& ctx){
+    Report()<<"instruction selection: "<<ctx.selectRewrites<<" rewrites, "<<ctx.selectSaved<<" bytes smaller than the generic forms"<<std::endl;
+}
+
+// only the tokens and the parser's tables, the IR and the codegen containers are on the heap
+void PrintArenaStats(ParsedContext& ctx){
+    Report()<<"frontend arena: "<<ctx.arena.allocations<<" allocations in "<<ctx.arena.blocks<<" blocks, "<<ctx.arena.bytes<<" bytes"<<std::endl;
+}
+
+void PrintFrameStats(ParsedContext& ctx, std::vector<BFFunction>& funcs){
+    Report()<<"frame sizes:"<<std::endl;
+    for(BFFunction& fn : funcs){
+        Label& lbl = ctx.labels[fn.label];
+        if(!fn.live){
+            Report()<<'\t'<<lbl<<": unreachable, not emitted"<<std::endl;
+            continue;
+        }
+        if(fn.folded){
+            for(BFFunction& other : funcs){
+                if(std::find(other.aliases.begin(), other.aliases.end(), fn.label) != other.aliases.end()){
+                    Report()<<'\t'<<lbl<<": same body as "<<ctx.labels[other.label]<<", emitted as an alias"<<std::endl;
+                }
+            }
+            continue;
+        }
+        Report()<<'\t'<<lbl<<": "<<lbl.frameAlloc<<" bytes";
+        if(CHECKED_TAPE){
+            Report()<<" (checked tape slot of "<<TapeStride() - TAPE_PAGE<<")";
+        }
+        else if(!lbl.frameBounded){
+            Report()<<" (unbounded)";
+        }
+        if(lbl.extraAlloc > 0){
+            Report()<<" + "<<lbl.extraAlloc<<" inline";
+        }
+        if(lbl.savedRegs > 0){
+            Report()<<", "<<lbl.savedRegs<<" counter registers";
+        }
+        if(fn.clobbers != (1 << TR_COUNT) - 1){
+            Report()<<", calls keep";
+            for(int r = 0; r < TR_COUNT; r++){
+                if(!(fn.clobbers & (1 << r))){
+                    Report()<<' '<<GenerateRegisterOP(GetTrackedRegister(ctx.regs, (TrackedRegister)r));
+                }
+            }
+        }
+        Report()<<std::endl;
+    }
+}
+
+inline void GenerateInstructionComment(std::ofstream& file, BFOp& op){
+    char cc;
+    switch(op.type){
+        case BFOpType::LEFT:
+            cc = '<';
+            break;
+        case BFOpType::RIGHT:
+            cc = '>';
+            break;
+        case BFOpType::PLUS:
+            cc = '+';
+            break;
+        case BFOpType::MINUS:
+            cc = '-';
+            break;
+        case BFOpType::OUTPUT:
+            cc = '.';
+            break;
+        case BFOpType::ARGUMENT:
+            cc = '*';
+            break;
+        case BFOpType::GETARG:
+            cc = '&';
+            break;
+        default:
+            cc = ' ';
+            break;
+    }
+    for(size_t i = 0; i < op.count; i++){
+        file<<cc;
+    }
+}
+
+inline std::ofstream& GenerateRegisterLoad(ParsedContext& ctx, std::ofstream& file, TrackedRegister reg, RegValue val){
+    Register& dst = GetTrackedRegister(ctx.regs, reg);
+    file<<'\t';
+    if(val.kind == RegValueKind::Frame){
+        if(val.value == 0){
+            file<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
+            file<<GenerateRegisterOP(ctx.regs.frameReg)<<", "<<GenerateRegisterOP(dst);
+        }
+        else{
+            file<<"leaq "<<val.value<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", "<<GenerateRegisterOP(dst);
+        }
+    }
+    else{
+        SelectRegisterConstant(ctx, file, val.value, dst);
+    }
+    file<<std::endl;
+    return file;
+}
+
+inline std::ofstream& GenerateGlobals(ParsedContext& ctx, std::vector<BFFunction>& funcs, std::ofstream& file){
+    for(BFFunction& fn : funcs){
+        if(fn.live){
+            file<<'\t'<<GetGlobalSyntax()<<' '<<ctx.labels[fn.label].Name<<std::endl;
+        }
+    }
+    return file;
+}
+
+inline std::ofstream& GenerateExterns(ParsedContext& ctx, std::ofstream& file){
+    for(std::string_view str : ctx.externs){
+        file<<'\t'<<GetExternSyntax()<<' '<<str<<std::endl;
+    }
+    if(!ctx.spawns.empty()){
+        file<<'\t'<<GetExternSyntax()<<" __bfpp_spawn"<<std::endl;
+    }
+    if(!ctx.joins.empty()){
+        file<<'\t'<<GetExternSyntax()<<" __bfpp_join"<<std::endl;
+    }
+    return file;
+}
+
+// ?spawn only runs labels of this program, it has no way to know what an extern expects
+bool CheckSpawns(ParsedContext& ctx){
+    bool ok = true;
+    for(Call& sp : ctx.spawns){
+        bool found = false;
+        for(Label& lbl : ctx.labels){
+            if(lbl.Name == sp.name){
+                found = true;
+                break;
+            }
+        }
+        if(!found){
+            Diag()<<"bf++: error: ?spawn needs a label of this program, "<<sp.name<<" on line "<<ctx.tokens[sp.pos].line<<" is not one"<<std::endl;
+            ok = false;
+        }
+    }
+    if(CHECKED_TAPE && !ctx.spawns.empty()){
+        Diag()<<"bf++: error: ?spawn cannot be used with --checked-tape, the tape stack is shared"<<std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+inline bool CheckBinRegister(ParsedContext& ctx, BinUse& use){
+    if(use.reg > 6){
+        Diag()<<"bf++: error: ?bin can only load argument registers 1 to 6, on line "<<ctx.tokens[use.pos].line<<std::endl;
+        return false;
+    }
+    return true;
+}
+
+// every ?include_bin becomes an absolute path, the assembler may run somewhere else
+bool CheckIncludes(ParsedContext& ctx){
+    bool ok = true;
+    for(size_t i = 0; i < ctx.includes.size(); i++){
+        BinInclude& inc = ctx.includes[i];
+        for(size_t j = 0; j < i; j++){
+            if(ctx.includes[j].name == inc.name){
+                Diag()<<"bf++: error: ?include_bin "<<inc.name<<" on line "<<inc.line<<" is already defined on line "<<ctx.includes[j].line<<std::endl;
+                ok = false;
+            }
+        }
+        std::string path(inc.path);
+        if(path.empty() || path[0] != '/'){
+            path = ctx.sourceDir + '/' + path;
+        }
+#ifdef _WIN32
+        char* full = _fullpath(nullptr, path.c_str(), 0);
+#else
+        char* full = realpath(path.c_str(), nullptr);
+#endif
+        if(full == nullptr || !std::ifstream(full, std::ios::binary)){
+            Diag()<<"bf++: error: cannot read "<<inc.path<<" for ?include_bin on line "<<inc.line<<std::endl;
+            ok = false;
+        }
+        ctx.includePaths.push_back(full ? full : path);
+        std::free(full);
+    }
+    for(BinUse& use : ctx.binUses){
+        bool found = false;
+        for(BinInclude& inc : ctx.includes){
+            found |= inc.name == use.name;
+        }
+        if(!found){
+            Diag()<<"bf++: error: ?bin needs an ?include_bin name, "<<use.name<<" on line "<<ctx.tokens[use.pos].line<<" is not one"<<std::endl;
+            ok = false;
+        }
+        if(!CheckBinRegister(ctx, use)){
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+inline const char* GetCallSyntax(){
+    return "call";
+}
+
+inline Register* GetArgumentRegister(ParsedContext& ctx, unsigned int count){
+    if(count < 1 || count > 6){
+        return nullptr;
+    }
+    return &GetTrackedRegister(ctx.regs, (TrackedRegister)count);
+}
+
+inline bool IsInnermostLoop(BFFunction& fn, size_t start){
+    for(size_t i = start + 1; i < fn.ops[start].match; i++){
+        if(fn.ops[i].type == BFOpType::LOOP_START){
+            return false;
+        }
+    }
+    return true;
+}
+
+// vector ops work on xmm0/ymm0, constants are broadcast bytes in .rodata
+inline std::string GenerateVectorConst(ParsedContext& ctx, uint8_t val){
+    ctx.vectorConsts[val] = true;
+    return ".Lbfpp_vec_" + std::to_string(val) + "(%rip)";
+}
+
+inline const char* GetVectorRegister(Widths width){
+    return width == Widths::Ymm ? "%ymm0" : "%xmm0";
+}
+
+// loads the cell into the vector register, the VEX form keeps SSE and AVX code from mixing
+inline void GenerateVectorLoad(ParsedContext& ctx, BFFunction& fn, Widths width, std::ofstream& file){
+    file<<'\t'<<(fn.avx ? "vmovdqu " : "movdqu ")<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", "<<GetVectorRegister(width)<<std::endl;
+}
+
+inline void GenerateVectorStore(ParsedContext& ctx, BFFunction& fn, Widths width, std::ofstream& file){
+    file<<'\t'<<(fn.avx ? "vmovdqu " : "movdqu ")<<GetVectorRegister(width)<<", "<<GenerateMemRegisterOP(ctx.regs.frameReg)<<std::endl;
+}
+
+// lane wise '+', '-' and '?mov', every byte lane gets the same constant
+void GenerateVectorOp(ParsedContext& ctx, BFFunction& fn, BFOp& op, std::ofstream& file){
+    const char* vreg = GetVectorRegister(op.width);
+    if(ctx.vectorWidth < op.width){
+        ctx.vectorWidth = op.width;
+    }
+    if(op.type == BFOpType::MOV){
+        uint8_t val = op.val & 0xFF;
+        if(val == 0){
+            if(fn.avx){
+                file<<'\t'<<"vpxor "<<vreg<<", "<<vreg<<", "<<vreg<<std::endl;
+            }
+            else{
+                file<<'\t'<<"pxor "<<vreg<<", "<<vreg<<std::endl;
+            }
+        }
+        else{
+            file<<'\t'<<(fn.avx ? "vmovdqa " : "movdqa ")<<GenerateVectorConst(ctx, val)<<", "<<vreg<<std::endl;
+        }
+        GenerateVectorStore(ctx, fn, op.width, file);
+        return;
+    }
+    uint8_t val = op.count & 0xFF;
+    if(val == 0){
+        // a multiple of 256 wraps every lane back to where it was
+        return;
+    }
+    const char* ins = op.type == BFOpType::PLUS ? "paddb " : "psubb ";
+    GenerateVectorLoad(ctx, fn, op.width, file);
+    if(fn.avx){
+        file<<'\t'<<'v'<<ins<<GenerateVectorConst(ctx, val)<<", "<<vreg<<", "<<vreg<<std::endl;
+    }
+    else{
+        file<<'\t'<<ins<<GenerateVectorConst(ctx, val)<<", "<<vreg<<std::endl;
+    }
+    GenerateVectorStore(ctx, fn, op.width, file);
+}
+
+// float cells go through xmm15 so the argument registers xmm0-7 keep what '*' put into them,
+// the constants the arithmetic adds live in .rodata like the vector ones
+inline std::string GetFloatRegister(unsigned int n){
+    return "%xmm" + std::to_string(n);
+}
+
+inline const char* GetFloatSuffix(Widths width){
+    return width == Widths::F32 ? "ss" : "sd";
+}
+
+inline std::string GenerateFloatConstName(Widths width, uint64_t bits){
+    std::stringstream name;
+    name<<".Lbfpp_f"<<GetMultiplier(width) * 8<<'_'<<std::hex<<bits;
+    return name.str();
+}
+
+inline std::string GenerateFloatConst(ParsedContext& ctx, Widths width, uint64_t bits){
+    std::pair<Widths, uint64_t> val(width, bits);
+    if(std::find(ctx.floatConsts.begin(), ctx.floatConsts.end(), val) == ctx.floatConsts.end()){
+        ctx.floatConsts.push_back(val);
+    }
+    return GenerateFloatConstName(width, bits) + "(%rip)";
+}
+
+// cell into an xmm register or back, a load clears the rest of the register
+inline void GenerateFloatMove(ParsedContext& ctx, BFFunction& fn, Widths width, const std::string& xmm, bool load, std::ofstream& file){
+    file<<'\t'<<(fn.avx ? "vmov" : "mov")<<GetFloatSuffix(width)<<' ';
+    if(load){
+        file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", "<<xmm<<std::endl;
+    }
+    else{
+        file<<xmm<<", "<<GenerateMemRegisterOP(ctx.regs.frameReg)<<std::endl;
+    }
+}
+
+// '+', '-', '?mov', '*' and '&' on a float cell, '*N' and '&N' use xmm(N-1) like SysV passes floats
+void GenerateFloatOp(ParsedContext& ctx, BFFunction& fn, BFOp& op, std::ofstream& file){
+    std::string scratch = GetFloatRegister(15);
+    switch(op.type){
+        case BFOpType::MOV:
+            if(op.width == Widths::F32 || op.val == 0){
+                // the bits fit an immediate
+                file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, op.width)<<' ';
+                file<<GenerateDirectOP(op.val)<<", "<<GenerateMemRegisterOP(ctx.regs.frameReg)<<std::endl;
+            }
+            else{
+                file<<'\t'<<(fn.avx ? "vmovsd " : "movsd ")<<GenerateFloatConst(ctx, op.width, op.val)<<", "<<scratch<<std::endl;
+                GenerateFloatMove(ctx, fn, op.width, scratch, false, file);
+            }
+            return;
+        case BFOpType::PLUS:
+        case BFOpType::MINUS:
+            GenerateFloatMove(ctx, fn, op.width, scratch, true, file);
+            file<<'\t'<<(fn.avx ? "v" : "")<<(op.type == BFOpType::PLUS ? "add" : "sub")<<GetFloatSuffix(op.width)<<' ';
+            file<<GenerateFloatConst(ctx, op.width, op.val)<<", "<<scratch;
+            if(fn.avx){
+                file<<", "<<scratch;
+            }
+            file<<std::endl;
+            GenerateFloatMove(ctx, fn, op.width, scratch, false, file);
+            break;
+        case BFOpType::ARGUMENT:
+            GenerateFloatMove(ctx, fn, op.width, GetFloatRegister(op.count - 1), true, file);
+            break;
+        case BFOpType::GETARG:
+            GenerateFloatMove(ctx, fn, op.width, GetFloatRegister(op.count - 1), false, file);
+            break;
+        default:
+            return;
+    }
+    file<<"\t#\t";
+    GenerateInstructionComment(file, op);
+    file<<std::endl;
+}
+
+// sets ZF when the cell is zero, a vector cell is zero when all of its lanes are and a float cell
+// when it compares equal to 0.0 or is NaN
+inline void GenerateCellTest(ParsedContext& ctx, BFFunction& fn, Widths width, std::ofstream& file){
+    if(IsFloatWidth(width)){
+        std::string scratch = GetFloatRegister(15);
+        if(fn.avx){
+            file<<'\t'<<"vxorps "<<scratch<<", "<<scratch<<", "<<scratch<<std::endl;
+        }
+        else{
+            file<<'\t'<<"xorps "<<scratch<<", "<<scratch<<std::endl;
+        }
+        file<<'\t'<<(fn.avx ? "vucomi" : "ucomi")<<GetFloatSuffix(width)<<' '<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", "<<scratch<<std::endl;
+        return;
+    }
+    if(IsVectorWidth(width)){
+        if(ctx.vectorWidth < width){
+            ctx.vectorWidth = width;
+        }
+        const char* vreg = GetVectorRegister(width);
+        GenerateVectorLoad(ctx, fn, width, file);
+        file<<'\t'<<(fn.avx ? "vptest " : "ptest ")<<vreg<<", "<<vreg<<std::endl;
+        return;
+    }
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::CMP, width)<<' ';
+    file<<GenerateDirectOP(0)<<", "<<GenerateMemRegisterOP(ctx.regs.frameReg)<<std::endl;
+}
+
+// the upper ymm halves have to be clean before anything SSE encoded runs
+inline void GenerateVZeroUpper(BFFunction& fn, std::ofstream& file){
+    if(fn.avx){
+        file<<'\t'<<"vzeroupper"<<std::endl;
+    }
+}
+
+// bottom test of a rotated loop, reuses what the op before ']' already knows about the cell
+void GenerateLoopTest(ParsedContext& ctx, BFFunction& fn, size_t end, std::ofstream& file){
+    BFOp& loop = fn.ops[fn.ops[end].match];
+    std::string start = "__loop__start__" + std::to_string(loop.target);
+    int width = GetMultiplier(loop.width);
+    if(end - 1 != fn.ops[end].match){
+        BFOp& last = fn.ops[end - 1];
+        switch(last.type){
+            case BFOpType::PLUS:
+            case BFOpType::MINUS:
+                // add/sub on the cell left ZF set for it, the vector and float ones leave no flags
+                if(last.width == loop.width && !IsVectorWidth(loop.width) && !IsFloatWidth(loop.width)){
+                    file<<'\t'<<"jne "<<start<<std::endl;
+                    return;
+                }
+                break;
+            case BFOpType::MOV:
+                // a float cell holding -0.0 has bits set and still ends the loop
+                if(GetMultiplier(last.width) >= width && !IsFloatWidth(loop.width)){
+                    unsigned long long val = IsVectorWidth(last.width) ? last.val & 0xFF : last.val;
+                    unsigned long long mask = width >= 8 ? ~0ULL : (1ULL << (width * 8)) - 1;
+                    if((val & mask) != 0){
+                        file<<'\t'<<GetUJumpSyntax()<<' '<<start<<std::endl;
+                    }
+                    return;
+                }
+                break;
+            case BFOpType::LOOP_END:
+            case BFOpType::SCAN:{
+                // an inner loop only falls through once the cell it tests, at the width of its '[', is zero,
+                // a ?times loop once its count ran out. float and integer zero only agree at the same float width
+                Widths inner = last.type == BFOpType::LOOP_END ? fn.ops[last.match].width : last.width;
+                if(!last.counted && (IsFloatWidth(inner) || IsFloatWidth(loop.width) ? inner == loop.width :
+                    GetMultiplier(inner) >= width)){
+                    return;
+                }
+                break;
+            }
+            case BFOpType::RET:
+            case BFOpType::INLINE_RET:
+            case BFOpType::TAIL_CALL:
+                return;
+            default:
+                break;
+        }
+    }
+    GenerateCellTest(ctx, fn, loop.width, file);
+    file<<'\t'<<"jne "<<start<<std::endl;
+}
+
+// puts back what the compile time run of main left: the tape, its output and the argument registers
+void GeneratePreload(ParsedContext& ctx, BFOp& op, std::ofstream& file){
+    PartialEval& pe = ctx.partial;
+    file<<"\t#\tpartially evaluated, "<<pe.steps<<" ops ran at compile time"<<std::endl;
+
+    // registers main got from its caller and still passes on, unless the copy or the write overwrite them
+    uint8_t clobbered = 0;
+    if(op.count > 0){
+        clobbered |= 1 << TR_ARG1 | 1 << TR_ARG2 | 1 << TR_ARG4;
+    }
+    if(!pe.output.empty()){
+        clobbered |= 1 << TR_ARG1 | 1 << TR_ARG2 | 1 << TR_ARG3 | 1 << TR_ARG4;
+    }
+    std::vector<TrackedRegister> kept;
+    for(int r = TR_ARG1; r < TR_COUNT; r++){
+        if((clobbered & (1 << r)) && pe.regs[r].caller && pe.regs[r].known != 0xFF){
+            kept.push_back((TrackedRegister)r);
+            file<<'\t'<<GeneratePushRegister(GetTrackedRegister(ctx.regs, (TrackedRegister)r), Widths::Qword)<<std::endl;
+            if(DEBUG_INFO){
+                file<<'\t'<<".cfi_adjust_cfa_offset 8"<<std::endl;
+            }
+        }
+    }
+
+    if(op.count > 0){
+        file<<'\t'<<"leaq .Lbfpp_pe_tape(%rip), "<<GenerateRegisterOP(ctx.regs.rsi)<<std::endl;
+        file<<'\t'<<"leaq ";
+        if(op.val != 0){
+            file<<op.val;
+        }
+        file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", "<<GenerateRegisterOP(ctx.regs.rdi)<<std::endl;
+        file<<'\t'<<"movl $"<<op.count<<", %ecx"<<std::endl;
+        file<<'\t'<<"rep movsb"<<std::endl;
+    }
+    if(!pe.output.empty()){
+        // one write for everything it printed, looping over short writes
+        file<<'\t'<<"movl $"<<SYS_OUT<<", %edi"<<std::endl;
+        file<<'\t'<<"leaq .Lbfpp_pe_out(%rip), "<<GenerateRegisterOP(ctx.regs.rsi)<<std::endl;
+        file<<'\t'<<"movl $"<<pe.output.size()<<", %edx"<<std::endl;
+        file<<".Lbfpp_pe_write:"<<std::endl;
+        file<<'\t'<<"movl $"<<SYS_OUT_INDEX<<", %eax"<<std::endl;
+        file<<'\t'<<GenerateInstruction(AssemblyInstruction::SYSCALL, Widths::Byte)<<std::endl;
+        file<<'\t'<<"testq %rax, %rax"<<std::endl;
+        file<<'\t'<<"jle .Lbfpp_pe_written"<<std::endl;
+        file<<'\t'<<"addq %rax, %rsi"<<std::endl;
+        file<<'\t'<<"subq %rax, %rdx"<<std::endl;
+        file<<'\t'<<"jnz .Lbfpp_pe_write"<<std::endl;
+        file<<".Lbfpp_pe_written:"<<std::endl;
+    }
+    for(size_t k = kept.size(); k-- > 0;){
+        file<<'\t'<<GenerateInstruction(AssemblyInstruction::POP, Widths::Qword)<<' ';
+        file<<GenerateRegisterOP(GetTrackedRegister(ctx.regs, kept[k]))<<std::endl;
+        if(DEBUG_INFO){
+            file<<'\t'<<".cfi_adjust_cfa_offset -8"<<std::endl;
+        }
+    }
+
+    for(int r = TR_ARG1; r < TR_COUNT; r++){
+        PEReg& reg = pe.regs[r];
+        Register& target = GetTrackedRegister(ctx.regs, (TrackedRegister)r);
+        if(reg.known == 0){
+            continue;
+        }
+        if(reg.known != 0xFF && reg.caller){
+            // only the low bytes were set, the rest is still the caller's
+            Widths width = reg.known == 1 ? Widths::Byte : Widths::Word;
+            file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, width)<<' ';
+            file<<GenerateDirectOP((long long)(reg.val & (reg.known == 1 ? 0xFF : 0xFFFF)))<<", %"<<GetRegisterWidth(target, width)<<std::endl;
+        }
+        else if((long long)reg.val == (int32_t)reg.val){
+            file<<'\t';
+            SelectRegisterConstant(ctx, file, reg.val, target)<<std::endl;
+        }
+        else{
+            file<<'\t'<<"movabsq "<<GenerateDirectOP((long long)reg.val)<<", "<<GenerateRegisterOP(target)<<std::endl;
+        }
+    }
+}
+
+inline void GenerateByteData(std::ofstream& file, std::vector<uint8_t>& bytes){
+    for(size_t b = 0; b < bytes.size(); b++){
+        file<<(b % 16 == 0 ? "\t.byte " : ", ")<<(unsigned int)bytes[b];
+        if(b % 16 == 15 || b + 1 == bytes.size()){
+            file<<std::endl;
+        }
+    }
+}
+
+std::ofstream& GeneratePartialData(ParsedContext& ctx, std::ofstream& file){
+    file<<'\t'<<".section .rodata"<<std::endl;
+    if(!ctx.partial.tape.empty()){
+        file<<".Lbfpp_pe_tape:"<<std::endl;
+        GenerateByteData(file, ctx.partial.tape);
+    }
+    if(!ctx.partial.output.empty()){
+        file<<".Lbfpp_pe_out:"<<std::endl;
+        GenerateByteData(file, ctx.partial.output);
+    }
+    return file;
+}
+
+inline std::string EscapeString(const std::string& str){
+    std::string out;
+    for(char c : str){
+        if(c == '"' || c == '\\'){
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+// included files go in as they are, aligned so tables start on a cache line
+std::ofstream& GenerateBinData(ParsedContext& ctx, std::ofstream& file){
+    file<<'\t'<<".section .rodata"<<std::endl;
+    for(size_t i = 0; i < ctx.includes.size(); i++){
+        file<<'\t'<<AlignTo(6)<<std::endl;
+        file<<".Lbfpp_bin_"<<ctx.includes[i].name<<':'<<std::endl;
+        file<<'\t'<<".incbin \""<<EscapeString(ctx.includePaths[i])<<'"'<<std::endl;
+    }
+    return file;
+}
+
+// a section per label so the linker can drop unused ones with --gc-sections, labels the profile
+// never saw and the loops it never saw go to .text.unlikely.<label>
+inline std::string GetFunctionSectionSyntax(Label& lbl, bool cold){
+    return std::string(".section .text.") + (cold ? "unlikely." : "") + std::string(lbl.Name) + ",\"ax\",@progbits";
+}
+
+inline void GenerateCounter(std::ofstream& file, size_t counter){
+    // plain increments, spawned tasks racing on a counter only lose a few counts
+    file<<'\t'<<"incq __bfpp_prof_counts+"<<counter * 8<<"(%rip)"<<std::endl;
+}
+
+inline void GenerateLineMark(ParsedContext& ctx, std::ofstream& file, size_t line, size_t label){
+    file<<".Lbfpp_pc_"<<ctx.lineMarks.size()<<':'<<std::endl;
+    ctx.lineMarks.emplace_back(line, label);
+}
+
+// pc to line table and slot stride the checked tape runtime reads
+std::ofstream& GenerateLineTable(ParsedContext& ctx, std::ofstream& file){
+    file<<'\t'<<".section .data.rel.ro"<<std::endl;
+    file<<'\t'<<AlignTo(3)<<std::endl;
+    file<<'\t'<<GetGlobalSyntax()<<" __bfpp_tape_stride"<<std::endl;
+    file<<"__bfpp_tape_stride:"<<std::endl;
+    file<<'\t'<<".quad "<<TapeStride()<<std::endl;
+    file<<'\t'<<GetGlobalSyntax()<<" __bfpp_line_count"<<std::endl;
+    file<<"__bfpp_line_count:"<<std::endl;
+    file<<'\t'<<".quad "<<ctx.lineMarks.size()<<std::endl;
+    file<<'\t'<<GetGlobalSyntax()<<" __bfpp_line_table"<<std::endl;
+    file<<"__bfpp_line_table:"<<std::endl;
+    for(size_t i = 0; i < ctx.lineMarks.size(); i++){
+        LineMark& mark = ctx.lineMarks[i];
+        file<<'\t'<<".quad .Lbfpp_pc_"<<i<<", "<<mark.line<<", .Lbfpp_name_"<<mark.label<<std::endl;
+    }
+    file<<'\t'<<".section .rodata"<<std::endl;
+    for(size_t l = 0; l < ctx.labels.size(); l++){
+        file<<".Lbfpp_name_"<<l<<":"<<std::endl;
+        file<<'\t'<<".asciz \""<<ctx.labels[l]<<'"'<<std::endl;
+    }
+    return file;
+}
+
+// ?times loads its count into the loop's counter register, the loop is left once that runs down to zero
+void GenerateCountedStart(ParsedContext& ctx, BFFunction& fn, size_t start, std::ofstream& file){
+    BFOp& op = fn.ops[start];
+    Register& counter = GetCounterRegister(ctx.regs, op.counter);
+    std::string end = "__loop__end__" + std::to_string(op.target);
+    if(op.fromCell){
+        // the cell is read unsigned, narrow ones are zero extended
+        switch(op.width){
+            case Widths::Byte:
+                file<<'\t'<<"movzbl "<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", %"<<counter.lower32<<std::endl;
+                break;
+            case Widths::Word:
+                file<<'\t'<<"movzwl "<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", %"<<counter.lower32<<std::endl;
+                break;
+            case Widths::Dword:
+                file<<'\t'<<"movl "<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", %"<<counter.lower32<<std::endl;
+                break;
+            default:
+                file<<'\t'<<"movq "<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", "<<GenerateRegisterOP(counter)<<std::endl;
+                break;
+        }
+        file<<'\t'<<"testq "<<GenerateRegisterOP(counter)<<", "<<GenerateRegisterOP(counter)<<std::endl;
+        file<<'\t'<<"je "<<end<<std::endl;
+    }
+    else if(op.val == 0){
+        file<<'\t'<<GetUJumpSyntax()<<' '<<end<<std::endl;
+    }
+    else if((unsigned long long)op.val <= 0xFFFFFFFFULL){
+        file<<'\t'<<"movl "<<GenerateDirectOP(op.val)<<", %"<<counter.lower32<<std::endl;
+    }
+    else{
+        file<<'\t'<<"movabsq "<<GenerateDirectOP(op.val)<<", "<<GenerateRegisterOP(counter)<<std::endl;
+    }
+    if(IsInnermostLoop(fn, start)){
+        file<<'\t'<<AlignTo(4)<<",,10"<<std::endl;
+    }
+    file<<'\t'<<"__loop__start__"<<std::to_string(op.target)<<':'<<std::endl;
+    if(PROFILE_GENERATE && op.target < ctx.done_loops.size()){
+        GenerateCounter(file, ctx.labels.size() + op.target);
+    }
+}
+
+// '?write N'/'?read N', one syscall for all the cells unless it comes back short, an error or
+// the end of the input stops it
+void GenerateBlockIO(ParsedContext& ctx, RegisterState st, BFOp& op, std::ofstream& file){
+    unsigned long long size = (unsigned long long)op.count * GetMultiplier(op.width);
+    if(size == 0){
+        return;
+    }
+    bool write = op.type == BFOpType::WRITE;
+    RegValue fd(RegValueKind::Constant, write ? SYS_OUT : SYS_IN);
+    if(st.regs[TR_ARG1] != fd){
+        GenerateRegisterLoad(ctx, file, TR_ARG1, fd);
+    }
+    if(st.regs[TR_ARG2] != RegValue(RegValueKind::Frame, 0)){
+        GenerateRegisterLoad(ctx, file, TR_ARG2, RegValue(RegValueKind::Frame, 0));
+    }
+    if(size <= 0xFFFFFFFFULL){
+        file<<'\t'<<"movl "<<GenerateDirectOP(size)<<", %"<<ctx.regs.rdx.lower32<<std::endl;
+    }
+    else{
+        file<<'\t'<<"movabsq "<<GenerateDirectOP(size)<<", "<<GenerateRegisterOP(ctx.regs.rdx)<<std::endl;
+    }
+    size_t id = ctx.ioLoops++;
+    file<<".Lbfpp_io_"<<id<<':'<<std::endl;
+    file<<'\t'<<"movl "<<GenerateDirectOP(write ? SYS_OUT_INDEX : SYS_IN_INDEX)<<", %"<<ctx.regs.rax.lower32<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::SYSCALL, Widths::Byte)<<std::endl;
+    file<<'\t'<<"testq %rax, %rax"<<std::endl;
+    file<<'\t'<<"jle .Lbfpp_io_done_"<<id<<std::endl;
+    file<<'\t'<<"addq %rax, %rsi"<<std::endl;
+    file<<'\t'<<"subq %rax, %rdx"<<std::endl;
+    file<<'\t'<<"jnz .Lbfpp_io_"<<id<<std::endl;
+    file<<".Lbfpp_io_done_"<<id<<':'<<std::endl;
+    file<<"\t#\t?"<<(write ? "write " : "read ")<<op.count<<std::endl;
+}
+
+inline void GenerateLoc(ParsedContext& ctx, std::ofstream& file, size_t line){
+    if(line != ctx.locLine){
+        file<<'\t'<<".loc 1 "<<line<<std::endl;
+        ctx.locLine = line;
+    }
+}
+
+// emits ops [from, to), cold loops get deferred into cold unless it is null
+void GenerateOps(ParsedContext& ctx, BFFunction& fn, size_t from, size_t to, std::vector<size_t>* cold, std::ofstream& file){
+    Label& func = ctx.labels[fn.label];
+    for(size_t i = from; i < to; i++){
+        BFOp& op = fn.ops[i];
+        Widths currentWidth = op.width;
+        if(CHECKED_TAPE && op.pos < ctx.tokens.size()){
+            GenerateLineMark(ctx, file, ctx.tokens[op.pos].line, fn.label);
+        }
+        if(DEBUG_INFO && op.pos < ctx.tokens.size()){
+            GenerateLoc(ctx, file, ctx.tokens[op.pos].line);
+        }
+        if(op.type == BFOpType::LOOP_START){
+            RegisterState st = fn.regIn[i];
+            for(TrackedRegister reg : OutputRegisters){
+                if((op.hoist & (1 << reg)) && st.regs[reg] != HoistedValue(op, reg)){
+                    GenerateRegisterLoad(ctx, file, reg, HoistedValue(op, reg));
+                }
+            }
+            if(op.counted){
+                GenerateCountedStart(ctx, fn, i, file);
+                continue;
+            }
+            if(cold != nullptr && IsColdLoop(ctx, fn, op)){
+                // only the entry test stays, the body comes after the epilogue
+                GenerateCellTest(ctx, fn, currentWidth, file);
+                file<<'\t'<<"jne "<<"__loop__start__"<<std::to_string(op.target)<<std::endl;
+                file<<'\t'<<"__loop__end__"<<std::to_string(op.target)<<':'<<std::endl;
+                cold->push_back(i);
+                i = op.match;
+                continue;
+            }
+            if(!fn.structured){
+                file<<'\t'<<"__loop__start__"<<std::to_string(op.target)<<':'<<std::endl;
+            }
+            GenerateCellTest(ctx, fn, currentWidth, file);
+            file<<'\t'<<"je "<<"__loop__end__"<<std::to_string(op.target)<<std::endl;
+            if(fn.structured){
+                // rotated, the test above only guards the first iteration
+                if(IsInnermostLoop(fn, i)){
+                    file<<'\t'<<AlignTo(4)<<",,10"<<std::endl;
+                }
+                file<<'\t'<<"__loop__start__"<<std::to_string(op.target)<<':'<<std::endl;
+            }
+            if(PROFILE_GENERATE && op.target < ctx.done_loops.size()){
+                GenerateCounter(file, ctx.labels.size() + op.target);
+            }
+        }
+        else if(op.type == BFOpType::LOOP_END){
+            if(op.counted){
+                Register& counter = GetCounterRegister(ctx.regs, op.counter);
+                file<<'\t'<<"decq "<<GenerateRegisterOP(counter)<<std::endl;
+                file<<'\t'<<"jne "<<"__loop__start__"<<std::to_string(op.target)<<std::endl;
+            }
+            else if(!fn.structured){
+                file<<'\t'<<GetUJumpSyntax()<<' '<<"__loop__start__"<<std::to_string(op.target)<<std::endl;
+            }
+            else{
+                GenerateLoopTest(ctx, fn, i, file);
+            }
+            file<<'\t'<<"__loop__end__"<<std::to_string(op.target)<<':'<<std::endl;
+        }
+        else if(op.type == BFOpType::CALL && IsFloatWidth(currentWidth)){
+            GenerateVZeroUpper(fn, file);
+            file<<'\t'<<GetCallSyntax()<<' '<<op.name<<std::endl;
+            GenerateFloatMove(ctx, fn, currentWidth, GetFloatRegister(0), false, file);
+        }
+        else if(op.type == BFOpType::CALL){
+            GenerateVZeroUpper(fn, file);
+            file<<'\t'<<GetCallSyntax()<<' '<<op.name<<std::endl;
+            file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
+            file<<'%'<<GetRegisterWidth(ctx.regs.rax, currentWidth)<<", ";
+            file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<std::endl;
+        }
+        else if(op.type == BFOpType::SPAWN){
+            // the runtime takes the label in r10 so every argument register passes through
+            file<<'\t'<<"leaq "<<op.name<<"(%rip), "<<GenerateRegisterOP(ctx.regs.r10)<<std::endl;
+            GenerateVZeroUpper(fn, file);
+            file<<'\t'<<GetCallSyntax()<<" __bfpp_spawn"<<std::endl;
+        }
+        else if(op.type == BFOpType::JOIN){
+            GenerateVZeroUpper(fn, file);
+            file<<'\t'<<GetCallSyntax()<<" __bfpp_join"<<std::endl;
+            file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
+            file<<'%'<<GetRegisterWidth(ctx.regs.rax, currentWidth)<<", ";
+            file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<std::endl;
+        }
+        else if(op.type == BFOpType::SCAN){
+            GenerateVZeroUpper(fn, file);
+            file<<'\t'<<GetCallSyntax()<<" *"<<ctx.scans[op.target].Name()<<"(%rip)"<<std::endl;
+            file<<"\t#\t[";
+            for(size_t c = 0; c < op.count; c++){
+                file<<(ctx.scans[op.target].left ? '<' : '>');
+            }
+            file<<']'<<std::endl;
+        }
+        else if(op.type == BFOpType::TAIL_CALL){
+            GenerateVZeroUpper(fn, file);
+            if(DEBUG_INFO){
+                file<<'\t'<<".cfi_remember_state"<<std::endl;
+            }
+            GenerateFrameTeardown(ctx, file, func);
+            file<<'\t'<<GetUJumpSyntax()<<' '<<op.name<<std::endl;
+            if(DEBUG_INFO){
+                file<<'\t'<<".cfi_restore_state"<<std::endl;
+            }
+        }
+        else if(IsFloatWidth(currentWidth) && (op.type == BFOpType::MOV || op.type == BFOpType::PLUS || op.type == BFOpType::MINUS ||
+                op.type == BFOpType::ARGUMENT || op.type == BFOpType::GETARG)){
+            GenerateFloatOp(ctx, fn, op, file);
+        }
+        else if(IsVectorWidth(currentWidth) && (op.type == BFOpType::MOV || op.type == BFOpType::PLUS || op.type == BFOpType::MINUS)){
+            GenerateVectorOp(ctx, fn, op, file);
+            if(op.type != BFOpType::MOV){
+                file<<"\t#\t";
+                GenerateInstructionComment(file, op);
+                file<<std::endl;
+            }
+        }
+        else if(op.type == BFOpType::MOV){
+            file<<'\t';
+            file<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
+            file<<GenerateDirectOP(op.val)<<", "<<GenerateMemRegisterOP(ctx.regs.frameReg);
+            file<<std::endl;
+        }
+        else if(op.type == BFOpType::PRELOAD){
+            GeneratePreload(ctx, op, file);
+        }
+        else if(op.type == BFOpType::SAVE || op.type == BFOpType::RESTORE){
+            Register& checkpoint = GetCounterRegister(ctx.regs, op.counter);
+            bool save = op.type == BFOpType::SAVE;
+            file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
+            file<<GenerateRegisterOP(save ? ctx.regs.frameReg : checkpoint)<<", "<<GenerateRegisterOP(save ? checkpoint : ctx.regs.frameReg)<<std::endl;
+            file<<"\t#\t?"<<(save ? "save " : "restore ")<<op.name<<std::endl;
+        }
+        else if(op.type == BFOpType::WRITE || op.type == BFOpType::READ){
+            GenerateBlockIO(ctx, fn.regIn[i], op, file);
+        }
+        else if(op.type == BFOpType::BIN){
+            Register* reg = op.count == 0 ? &ctx.regs.frameReg : GetArgumentRegister(ctx, op.count);
+            file<<'\t'<<"leaq .Lbfpp_bin_"<<op.name<<"(%rip), "<<GenerateRegisterOP(*reg)<<std::endl;
+        }
+        else if(op.type == BFOpType::INLINE_START){
+            // caller's pointer goes into the first slot of the inline area
+            file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
+            file<<GenerateRegisterOP(ctx.regs.frameReg)<<", "<<func.frameAlloc<<GenerateMemRegisterOP(ctx.regs.stackReg)<<std::endl;
+            file<<'\t'<<"leaq "<<func.frameAlloc + op.val<<GenerateMemRegisterOP(ctx.regs.stackReg)<<", ";
+            file<<GenerateRegisterOP(ctx.regs.frameReg)<<std::endl;
+            file<<"\t#\tinlined "<<op.name<<std::endl;
+        }
+        else if(op.type == BFOpType::INLINE_RET){
+            if(ctx.labels[op.val].type != Keyword::Void && IsFloatWidth(currentWidth)){
+                GenerateFloatMove(ctx, fn, currentWidth, GetFloatRegister(0), true, file);
+            }
+            else if(ctx.labels[op.val].type != Keyword::Void){
+                file<<'\t';
+                if(currentWidth == Widths::Byte || currentWidth == Widths::Word){
+                    // only the store after the inlined body reads rax, a narrow mov would merge
+                    // into whatever rax held before and wait on it
+                    file<<(currentWidth == Widths::Byte ? "movzbl " : "movzwl ");
+                    file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", %"<<ctx.regs.rax.lower32;
+                    CountSelection(ctx, currentWidth == Widths::Byte ? -1 : 0);
+                }
+                else{
+                    file<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
+                    file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", %"<<GetRegisterWidth(ctx.regs.rax, currentWidth);
+                }
+                file<<std::endl;
+            }
+            file<<'\t'<<GetUJumpSyntax()<<' '<<"__inline__end__"<<std::to_string(op.target)<<std::endl;
+        }
+        else if(op.type == BFOpType::INLINE_END){
+            file<<'\t'<<"__inline__end__"<<std::to_string(op.target)<<':'<<std::endl;
+            file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
+            file<<func.frameAlloc<<GenerateMemRegisterOP(ctx.regs.stackReg)<<", "<<GenerateRegisterOP(ctx.regs.frameReg)<<std::endl;
+            if(IsFloatWidth(currentWidth)){
+                GenerateFloatMove(ctx, fn, currentWidth, GetFloatRegister(0), false, file);
+            }
+            else{
+                file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
+                file<<'%'<<GetRegisterWidth(ctx.regs.rax, currentWidth)<<", ";
+                file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<std::endl;
+            }
+        }
+        else if(op.type == BFOpType::RET){
+            Label& lbl = ctx.labels[op.target];
+            if(lbl.type != Keyword::Void && IsFloatWidth(currentWidth)){
+                GenerateFloatMove(ctx, fn, currentWidth, GetFloatRegister(0), true, file);
+            }
+            else if(lbl.type != Keyword::Void){
+                file<<'\t';
+                file<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
+                file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", %"<<GetRegisterWidth(ctx.regs.rax, currentWidth);
+                file<<std::endl;
+            }
+            file<<'\t'<<GetUJumpSyntax()<<' ';
+            GenerateLabelEndName(lbl, file)<<std::endl;
+        }
+        else{
+            if(op.type == BFOpType::PLUS || op.type == BFOpType::MINUS){
+                SelectAdd(ctx, file, op.type == BFOpType::PLUS, currentWidth, op.count, GenerateMemRegisterOP(ctx.regs.frameReg), false);
+            }
+            else if(op.type == BFOpType::LEFT || op.type == BFOpType::RIGHT){
+                SelectAdd(ctx, file, op.type == BFOpType::RIGHT, Widths::Qword, op.count * GetMultiplier(currentWidth), GenerateRegisterOP(ctx.regs.frameReg), true);
+            }
+            else if(op.type == BFOpType::OUTPUT){
+                RegisterState st = fn.regIn[i];
+                for(size_t c = 0; c < op.count; c++){
+                    for(TrackedRegister reg : OutputRegisters){
+                        if(st.regs[reg] != OutputSetup(reg)){
+                            st.regs[reg] = OutputSetup(reg);
+                            GenerateRegisterLoad(ctx, file, reg, OutputSetup(reg));
+                        }
+                    }
+                    file<<'\t'<<GenerateInstruction(AssemblyInstruction::SYSCALL, Widths::Byte)<<std::endl;
+                    st.regs[TR_RAX] = RegValue();
+                    st.regs[TR_ARG4] = RegValue();
+                }
+            }
+            else if(op.type == BFOpType::ARGUMENT){
+                if(op.count <= 6){
+                    Register* reg = GetArgumentRegister(ctx, op.count);
+                    if(reg == nullptr){
+                        return;
+                    }
+                    file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
+                    if(!op.address){
+                        file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", ";
+                    }
+                    else{
+                        file<<GenerateRegisterOP(ctx.regs.frameReg)<<", ";
+                    }
+                    file<<'%'<<GetRegisterWidth(*reg, currentWidth)<<std::endl;
+                }
+                else{
+                    if(op.address){
+                        file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
+                        file<<GenerateRegisterOP(ctx.regs.frameReg)<<", ";
+                    }
+                    else{
+                        file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
+                        file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", %"<<GetRegisterWidth(ctx.regs.rax, currentWidth)<<std::endl;
+                        file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, Widths::Qword)<<' ';
+                        file<<GenerateRegisterOP(ctx.regs.rax)<<", ";
+                    }
+                    unsigned int offset = op.count - 7;
+                    if(offset > 0){
+                        file<<offset * 8;
+                    }
+                    file<<GenerateMemRegisterOP(ctx.regs.stackReg)<<std::endl;
+                }
+            }
+            else if(op.type == BFOpType::GETARG){
+                if(op.count <= 6){
+                    Register* reg = GetArgumentRegister(ctx, op.count);
+                    if(reg == nullptr){
+                        return;
+                    }
+                    file<<'\t'<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
+                    file<<'%'<<GetRegisterWidth(*reg, currentWidth)<<", ";
+                    if(op.address){
+                        file<<'%'<<GetRegisterWidth(ctx.regs.frameReg, currentWidth)<<std::endl;
+                    }
+                    else{
+                        file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<std::endl;
+                    }
+                }
+                else{
+                    Diag()<<"Accepting stack arguments isnt available currently"<<std::endl;
+                    // ugh i dont wanna
+                }
+            }
+            file<<"\t#\t";
+            GenerateInstructionComment(file, op);
+            file<<std::endl;
+        }
+    }
+
+}
+
+void GenerateFunction(ParsedContext& ctx, BFFunction& fn, std::ofstream& file){
+    Label& func = ctx.labels[fn.label];
+    for(BFOp& op : fn.ops){
+        if(op.width == Widths::Ymm){
+            fn.avx = true;
+        }
+    }
+    file<<'\t'<<GetFunctionSectionSyntax(func, ctx.profile.loaded && fn.weight == 0)<<std::endl;
+    file<<'\t'<<AlignTo(4)<<std::endl;
+    file<<'\t'<<".type "<<func.Name<<", @function"<<std::endl;
+    GenerateLabelName(func, file)<<":\n";
+    if(DEBUG_INFO){
+        file<<'\t'<<".cfi_startproc"<<std::endl;
+        ctx.locLine = 0;
+        GenerateLoc(ctx, file, ctx.tokens[func.pos].line);
+    }
+    if(CHECKED_TAPE){
+        GenerateLineMark(ctx, file, ctx.tokens[func.pos].line, fn.label);
+    }
+    if(PROFILE_GENERATE){
+        GenerateCounter(file, fn.label);
+    }
+    GeneratePrologue(ctx, file, func)<<std::endl;
+
+    std::vector<size_t> cold;
+    GenerateOps(ctx, fn, 0, fn.ops.size(), &cold, file);
+
+    GenerateLabelEnd(func, file);
+    GenerateVZeroUpper(fn, file);
+    GenerateEpilogue(ctx, file, func)<<std::endl;
+    if(DEBUG_INFO){
+        file<<'\t'<<".cfi_endproc"<<std::endl;
+    }
+    file<<'\t'<<".size "<<func.Name<<", .-"<<func.Name<<std::endl;
+    for(size_t a : fn.aliases){
+        Label& alias = ctx.labels[a];
+        file<<'\t'<<".type "<<alias.Name<<", @function"<<std::endl;
+        file<<'\t'<<".set "<<alias.Name<<", "<<func.Name<<std::endl;
+        file<<'\t'<<".size "<<alias.Name<<", .-"<<func.Name<<std::endl;
+    }
+
+    if(!cold.empty()){
+        file<<'\t'<<GetFunctionSectionSyntax(func, true)<<std::endl;
+        if(DEBUG_INFO){
+            // the cold bodies get an FDE of their own that starts with the whole frame in place
+            file<<'\t'<<".cfi_startproc"<<std::endl;
+            GenerateFrameCFI(ctx, file, func);
+            ctx.locLine = 0;
+        }
+        for(size_t i : cold){
+            BFOp& op = fn.ops[i];
+            file<<'\t'<<"__loop__start__"<<std::to_string(op.target)<<':'<<std::endl;
+            GenerateOps(ctx, fn, i + 1, op.match, nullptr, file);
+            GenerateLoopTest(ctx, fn, op.match, file);
+            file<<'\t'<<GetUJumpSyntax()<<' '<<"__loop__end__"<<std::to_string(op.target)<<std::endl;
+        }
+        if(DEBUG_INFO){
+            file<<'\t'<<".cfi_endproc"<<std::endl;
+        }
+    }
+}
+
+enum class ScanISA{
+    SSE2, AVX2, AVX512
+};
+
+// one search routine, rbp in and out, keeps everything but rax, r10, r11 and the first vector register.
+// chunks are aligned so a load never crosses into a page the scalar loop would not touch,
+// a mask with a bit on every byte a cell can start at picks the cells out of the zero bytes
+void GenerateScanVariant(ParsedContext& ctx, ScanRoutine& scan, ScanISA isa, std::ofstream& file){
+    int chunk = isa == ScanISA::SSE2 ? 16 : isa == ScanISA::AVX2 ? 32 : 64;
+    const char* suffix = isa == ScanISA::SSE2 ? "_sse2" : isa == ScanISA::AVX2 ? "_avx2" : "_avx512";
+    std::string name = scan.Name() + suffix;
+    unsigned long long starts = 0;
+    for(int b = 0; b < 64; b += scan.stride){
+        starts |= 1ULL << b;
+    }
+    Widths width = (Widths)scan.width;
+
+    file<<'\t'<<AlignTo(4)<<std::endl;
+    file<<name<<':'<<std::endl;
+    if(scan.width > 1){
+        // cells that are not aligned to their width would straddle chunks
+        file<<'\t'<<"testq $"<<scan.width - 1<<", "<<GenerateRegisterOP(ctx.regs.frameReg)<<std::endl;
+        file<<'\t'<<"jnz .L"<<name<<"_scalar"<<std::endl;
+    }
+    file<<'\t'<<GeneratePushRegister(ctx.regs.rcx, Widths::Qword)<<std::endl;
+    file<<'\t'<<GeneratePushRegister(ctx.regs.rdx, Widths::Qword)<<std::endl;
+    file<<'\t'<<"movq %rbp, %r10"<<std::endl;
+    file<<'\t'<<"andq $"<<-chunk<<", %r10"<<std::endl;
+    file<<'\t'<<"movl %ebp, %ecx"<<std::endl;
+    file<<'\t'<<"andl $"<<chunk - 1<<", %ecx"<<std::endl;
+    // the first chunk only counts from the start cell on, in the search direction
+    if(scan.left){
+        file<<'\t'<<"movq $2, %r11"<<std::endl;
+        file<<'\t'<<"shlq %cl, %r11"<<std::endl;
+        file<<'\t'<<"decq %r11"<<std::endl;
+    }
+    else{
+        file<<'\t'<<"movq $-1, %r11"<<std::endl;
+        file<<'\t'<<"shlq %cl, %r11"<<std::endl;
+    }
+    file<<'\t'<<"andl $"<<scan.stride - 1<<", %ecx"<<std::endl;
+    file<<'\t'<<"movabsq $"<<(long long)starts<<", %rdx"<<std::endl;
+    file<<'\t'<<"shlq %cl, %rdx"<<std::endl;
+    file<<'\t'<<"andq %rdx, %r11"<<std::endl;
+
+    file<<".L"<<name<<"_loop:"<<std::endl;
+    if(isa == ScanISA::SSE2){
+        file<<'\t'<<"pxor %xmm0, %xmm0"<<std::endl;
+        file<<'\t'<<"pcmpeqb (%r10), %xmm0"<<std::endl;
+        file<<'\t'<<"pmovmskb %xmm0, %eax"<<std::endl;
+    }
+    else if(isa == ScanISA::AVX2){
+        file<<'\t'<<"vpxor %ymm0, %ymm0, %ymm0"<<std::endl;
+        file<<'\t'<<"vpcmpeqb (%r10), %ymm0, %ymm0"<<std::endl;
+        file<<'\t'<<"vpmovmskb %ymm0, %eax"<<std::endl;
+    }
+    else{
+        file<<'\t'<<"vmovdqa64 (%r10), %zmm0"<<std::endl;
+        file<<'\t'<<"vptestnmb %zmm0, %zmm0, %k1"<<std::endl;
+        file<<'\t'<<"kmovq %k1, %rax"<<std::endl;
+    }
+    // a cell is zero when all of its bytes are, fold the following bytes onto its first
+    for(int w = 1; w < scan.width; w *= 2){
+        file<<'\t'<<"movq %rax, %rcx"<<std::endl;
+        file<<'\t'<<"shrq $"<<w<<", %rcx"<<std::endl;
+        file<<'\t'<<"andq %rcx, %rax"<<std::endl;
+    }
+    file<<'\t'<<"andq %r11, %rax"<<std::endl;
+    file<<'\t'<<"jnz .L"<<name<<"_found"<<std::endl;
+    file<<'\t'<<(scan.left ? "subq $" : "addq $")<<chunk<<", %r10"<<std::endl;
+    file<<'\t'<<"movq %rdx, %r11"<<std::endl;
+    file<<'\t'<<GetUJumpSyntax()<<" .L"<<name<<"_loop"<<std::endl;
+
+    file<<".L"<<name<<"_found:"<<std::endl;
+    file<<'\t'<<(scan.left ? "bsrq" : "bsfq")<<" %rax, %rax"<<std::endl;
+    file<<'\t'<<"leaq (%r10,%rax), %rbp"<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::POP, Widths::Qword)<<' '<<GenerateRegisterOP(ctx.regs.rdx)<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::POP, Widths::Qword)<<' '<<GenerateRegisterOP(ctx.regs.rcx)<<std::endl;
+    if(isa != ScanISA::SSE2){
+        file<<'\t'<<"vzeroupper"<<std::endl;
+    }
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::RET, Widths::Byte)<<std::endl;
+
+    if(scan.width > 1){
+        file<<".L"<<name<<"_scalar:"<<std::endl;
+        file<<'\t'<<GenerateInstruction(AssemblyInstruction::CMP, width)<<' ';
+        file<<GenerateDirectOP(0)<<", "<<GenerateMemRegisterOP(ctx.regs.frameReg)<<std::endl;
+        file<<'\t'<<"je .L"<<name<<"_done"<<std::endl;
+        file<<'\t'<<(scan.left ? "subq $" : "addq $")<<scan.stride<<", "<<GenerateRegisterOP(ctx.regs.frameReg)<<std::endl;
+        file<<'\t'<<GetUJumpSyntax()<<" .L"<<name<<"_scalar"<<std::endl;
+        file<<".L"<<name<<"_done:"<<std::endl;
+        file<<'\t'<<GenerateInstruction(AssemblyInstruction::RET, Widths::Byte)<<std::endl;
+    }
+}
+
+// every scan shape gets an SSE2, AVX2 and AVX-512 routine, the pointer starts on SSE2
+// and a startup routine moves it to the widest one cpuid and xgetbv allow
+std::ofstream& GenerateScanRoutines(ParsedContext& ctx, std::ofstream& file){
+    file<<'\t'<<".text"<<std::endl;
+    for(ScanRoutine& scan : ctx.scans){
+        GenerateScanVariant(ctx, scan, ScanISA::SSE2, file);
+        GenerateScanVariant(ctx, scan, ScanISA::AVX2, file);
+        GenerateScanVariant(ctx, scan, ScanISA::AVX512, file);
+    }
+
+    file<<'\t'<<AlignTo(4)<<std::endl;
+    file<<"__bfpp_scan_init:"<<std::endl;
+    file<<'\t'<<GeneratePushRegister(ctx.regs.rbx, Widths::Qword)<<std::endl;
+    file<<'\t'<<"movl $1, %eax"<<std::endl;
+    file<<'\t'<<"cpuid"<<std::endl;
+    file<<'\t'<<"andl $0x18000000, %ecx"<<std::endl;
+    file<<'\t'<<"cmpl $0x18000000, %ecx"<<std::endl;
+    file<<'\t'<<"jne .Lbfpp_scan_init_done"<<std::endl;
+    file<<'\t'<<"xorl %ecx, %ecx"<<std::endl;
+    file<<'\t'<<"xgetbv"<<std::endl;
+    file<<'\t'<<"movl %eax, %r10d"<<std::endl;
+    file<<'\t'<<"andl $6, %eax"<<std::endl;
+    file<<'\t'<<"cmpl $6, %eax"<<std::endl;
+    file<<'\t'<<"jne .Lbfpp_scan_init_done"<<std::endl;
+    file<<'\t'<<"movl $7, %eax"<<std::endl;
+    file<<'\t'<<"xorl %ecx, %ecx"<<std::endl;
+    file<<'\t'<<"cpuid"<<std::endl;
+    file<<'\t'<<"testl $0x20, %ebx"<<std::endl;
+    file<<'\t'<<"jz .Lbfpp_scan_init_done"<<std::endl;
+    for(ScanRoutine& scan : ctx.scans){
+        file<<'\t'<<"leaq "<<scan.Name()<<"_avx2(%rip), %rax"<<std::endl;
+        file<<'\t'<<"movq %rax, "<<scan.Name()<<"(%rip)"<<std::endl;
+    }
+    // AVX512F and AVX512BW, with the opmask and zmm state enabled
+    file<<'\t'<<"andl $0xE6, %r10d"<<std::endl;
+    file<<'\t'<<"cmpl $0xE6, %r10d"<<std::endl;
+    file<<'\t'<<"jne .Lbfpp_scan_init_done"<<std::endl;
+    file<<'\t'<<"andl $0x40010000, %ebx"<<std::endl;
+    file<<'\t'<<"cmpl $0x40010000, %ebx"<<std::endl;
+    file<<'\t'<<"jne .Lbfpp_scan_init_done"<<std::endl;
+    for(ScanRoutine& scan : ctx.scans){
+        file<<'\t'<<"leaq "<<scan.Name()<<"_avx512(%rip), %rax"<<std::endl;
+        file<<'\t'<<"movq %rax, "<<scan.Name()<<"(%rip)"<<std::endl;
+    }
+    file<<".Lbfpp_scan_init_done:"<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::POP, Widths::Qword)<<' '<<GenerateRegisterOP(ctx.regs.rbx)<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::RET, Widths::Byte)<<std::endl;
+
+    file<<'\t'<<".data"<<std::endl;
+    file<<'\t'<<AlignTo(3)<<std::endl;
+    for(ScanRoutine& scan : ctx.scans){
+        file<<scan.Name()<<':'<<std::endl;
+        file<<'\t'<<".quad "<<scan.Name()<<"_sse2"<<std::endl;
+    }
+    file<<'\t'<<".section .init_array,\"aw\""<<std::endl;
+    file<<'\t'<<AlignTo(3)<<std::endl;
+    file<<'\t'<<".quad __bfpp_scan_init"<<std::endl;
+    ctx.initRoutines.push_back("__bfpp_scan_init");
+    return file;
+}
+
+// entry point of freestanding executables, the kernel leaves argc, argv and envp on the stack
+std::ofstream& GenerateStart(ParsedContext& ctx, std::ofstream& file){
+    file<<'\t'<<".text"<<std::endl;
+    file<<'\t'<<GetGlobalSyntax()<<" _start"<<std::endl;
+    file<<'\t'<<AlignTo(4)<<std::endl;
+    file<<"_start:"<<std::endl;
+    file<<'\t'<<"xorl %ebp, %ebp"<<std::endl;
+    file<<'\t'<<"movq (%rsp), %rdi"<<std::endl;
+    file<<'\t'<<"leaq 8(%rsp), %rsi"<<std::endl;
+    file<<'\t'<<"leaq 16(%rsp,%rdi,8), %rdx"<<std::endl;
+    file<<'\t'<<"andq $-16, %rsp"<<std::endl;
+    if(!ctx.initRoutines.empty()){
+        // nothing runs .init_array without libc, the arguments survive in callee saved registers
+        file<<'\t'<<"movq %rdi, %r12"<<std::endl;
+        file<<'\t'<<"movq %rsi, %r13"<<std::endl;
+        file<<'\t'<<"movq %rdx, %r14"<<std::endl;
+        for(std::string& init : ctx.initRoutines){
+            file<<'\t'<<GetCallSyntax()<<' '<<init<<std::endl;
+        }
+        file<<'\t'<<"movq %r12, %rdi"<<std::endl;
+        file<<'\t'<<"movq %r13, %rsi"<<std::endl;
+        file<<'\t'<<"movq %r14, %rdx"<<std::endl;
+    }
+    file<<'\t'<<GetCallSyntax()<<" main"<<std::endl;
+    if(!ctx.finiRoutines.empty()){
+        file<<'\t'<<"movl %eax, %r12d"<<std::endl;
+        for(std::string& fini : ctx.finiRoutines){
+            file<<'\t'<<GetCallSyntax()<<' '<<fini<<std::endl;
+        }
+        file<<'\t'<<"movl %r12d, %eax"<<std::endl;
+    }
+    // exit_group(main's return value)
+    file<<'\t'<<"movl %eax, %edi"<<std::endl;
+    file<<'\t'<<"movl $231, %eax"<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::SYSCALL, Widths::Byte)<<std::endl;
+    return file;
+}
+
+// the counters with the header of the profile in front, written out in one piece at exit
+std::ofstream& GenerateProfileSupport(ParsedContext& ctx, std::ofstream& file){
+    file<<'\t'<<".data"<<std::endl;
+    file<<'\t'<<AlignTo(3)<<std::endl;
+    file<<"__bfpp_prof_data:"<<std::endl;
+    file<<'\t'<<".ascii \""<<PROFILE_MAGIC<<'"'<<std::endl;
+    file<<'\t'<<".quad "<<ctx.sourceHash<<", "<<ctx.labels.size()<<", "<<ctx.done_loops.size()<<std::endl;
+    file<<"__bfpp_prof_counts:"<<std::endl;
+    file<<'\t'<<".zero "<<(ctx.labels.size() + ctx.done_loops.size()) * 8<<std::endl;
+    file<<".Lbfpp_prof_end:"<<std::endl;
+    file<<'\t'<<".section .rodata"<<std::endl;
+    file<<".Lbfpp_prof_path:"<<std::endl;
+    file<<'\t'<<".asciz \""<<PROFILE_FILE<<'"'<<std::endl;
+
+    // raw syscalls so the freestanding programs can dump it too
+    file<<'\t'<<".text"<<std::endl;
+    file<<'\t'<<AlignTo(4)<<std::endl;
+    file<<"__bfpp_prof_dump:"<<std::endl;
+    // open(PROFILE_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644)
+    file<<'\t'<<"movl $2, %eax"<<std::endl;
+    file<<'\t'<<"leaq .Lbfpp_prof_path(%rip), %rdi"<<std::endl;
+    file<<'\t'<<"movl $0x241, %esi"<<std::endl;
+    file<<'\t'<<"movl $0644, %edx"<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::SYSCALL, Widths::Byte)<<std::endl;
+    file<<'\t'<<"testl %eax, %eax"<<std::endl;
+    file<<'\t'<<"js .Lbfpp_prof_done"<<std::endl;
+    file<<'\t'<<"movl %eax, %edi"<<std::endl;
+    file<<'\t'<<"leaq __bfpp_prof_data(%rip), %rsi"<<std::endl;
+    file<<'\t'<<"movl $.Lbfpp_prof_end - __bfpp_prof_data, %edx"<<std::endl;
+    // write until everything is out, the kernel keeps rdi
+    file<<".Lbfpp_prof_write:"<<std::endl;
+    file<<'\t'<<"movl $"<<SYS_OUT_INDEX<<", %eax"<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::SYSCALL, Widths::Byte)<<std::endl;
+    file<<'\t'<<"testq %rax, %rax"<<std::endl;
+    file<<'\t'<<"jle .Lbfpp_prof_close"<<std::endl;
+    file<<'\t'<<"addq %rax, %rsi"<<std::endl;
+    file<<'\t'<<"subq %rax, %rdx"<<std::endl;
+    file<<'\t'<<"jnz .Lbfpp_prof_write"<<std::endl;
+    file<<".Lbfpp_prof_close:"<<std::endl;
+    file<<'\t'<<"movl $3, %eax"<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::SYSCALL, Widths::Byte)<<std::endl;
+    file<<".Lbfpp_prof_done:"<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::RET, Widths::Byte)<<std::endl;
+
+    file<<'\t'<<".section .fini_array,\"aw\""<<std::endl;
+    file<<'\t'<<AlignTo(3)<<std::endl;
+    file<<'\t'<<".quad __bfpp_prof_dump"<<std::endl;
+    ctx.finiRoutines.push_back("__bfpp_prof_dump");
+    return file;
+}
+
+// the vector cells only exist on the tape, nothing moves them through a general register
+bool CheckVectorOps(ParsedContext& ctx, std::vector<BFFunction>& funcs){
+    bool ok = true;
+    for(BFFunction& fn : funcs){
+        for(BFOp& op : fn.ops){
+            if(!IsVectorWidth(op.width)){
+                continue;
+            }
+            const char* what = nullptr;
+            switch(op.type){
+                case BFOpType::ARGUMENT:
+                    what = "'*'";
+                    break;
+                case BFOpType::GETARG:
+                    what = "'&'";
+                    break;
+                case BFOpType::RET:
+                    what = "'!'";
+                    break;
+                case BFOpType::CALL:
+                    what = "?call";
+                    break;
+                case BFOpType::JOIN:
+                    what = "?join";
+                    break;
+                default:
+                    break;
+            }
+            if(what != nullptr){
+                Diag()<<"bf++: error: "<<what<<" cannot be used on vector cells, on line "<<ctx.tokens[op.pos].line<<std::endl;
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+// float cells move through xmm0-7, the ones SysV passes floats in, and never through a general register
+bool CheckFloatOps(ParsedContext& ctx, std::vector<BFFunction>& funcs){
+    bool ok = true;
+    for(BFFunction& fn : funcs){
+        for(BFOp& op : fn.ops){
+            if(!IsFloatWidth(op.width)){
+                continue;
+            }
+            size_t line = ctx.tokens[op.pos].line;
+            if((op.type == BFOpType::ARGUMENT || op.type == BFOpType::GETARG) && op.address){
+                Diag()<<"bf++: error: "<<(op.type == BFOpType::ARGUMENT ? "'*^'" : "'&^'")<<" cannot be used on float cells, on line "<<line<<std::endl;
+                ok = false;
+            }
+            else if((op.type == BFOpType::ARGUMENT || op.type == BFOpType::GETARG) && (op.count < 1 || op.count > 8)){
+                Diag()<<"bf++: error: float cells can only use argument registers 1 to 8, on line "<<line<<std::endl;
+                ok = false;
+            }
+            else if(op.type == BFOpType::JOIN){
+                Diag()<<"bf++: error: ?join cannot be used on float cells, on line "<<line<<std::endl;
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+bool CheckCountedLoops(ParsedContext& ctx, std::vector<BFFunction>& funcs){
+    bool ok = true;
+    for(BFFunction& fn : funcs){
+        for(BFOp& op : fn.ops){
+            if(!op.counted || op.type != BFOpType::LOOP_START){
+                continue;
+            }
+            if(!fn.structured){
+                Diag()<<"bf++: error: a ?times loop has to end inside its label, on line "<<ctx.tokens[op.pos].line<<std::endl;
+                ok = false;
+            }
+            else if(op.fromCell && IsVectorWidth(op.width)){
+                Diag()<<"bf++: error: ?times cannot take its count from a vector cell, on line "<<ctx.tokens[op.pos].line<<std::endl;
+                ok = false;
+            }
+            else if(op.fromCell && IsFloatWidth(op.width)){
+                Diag()<<"bf++: error: ?times cannot take its count from a float cell, on line "<<ctx.tokens[op.pos].line<<std::endl;
+                ok = false;
+            }
+        }
+        if(fn.structured && CountedDepth(fn.ops) > MAX_COUNTERS){
+            Diag()<<"bf++: error: "<<ctx.labels[fn.label]<<" nests ?times loops deeper than "<<MAX_COUNTERS<<std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// checkpoints share the callee saved registers with the ?times counters, a label gets MAX_COUNTERS of them
+bool CheckCheckpoints(ParsedContext& ctx, std::vector<BFFunction>& funcs){
+    bool ok = true;
+    for(BFFunction& fn : funcs){
+        std::vector<std::string_view> names = CheckpointNames(fn.ops);
+        if(names.empty()){
+            continue;
+        }
+        Label& lbl = ctx.labels[fn.label];
+        if(!fn.structured){
+            Diag()<<"bf++: error: ?save and ?restore need every loop of "<<lbl<<" to stay inside it"<<std::endl;
+            ok = false;
+            continue;
+        }
+        for(BFOp& op : fn.ops){
+            if(op.type != BFOpType::RESTORE){
+                continue;
+            }
+            bool saved = false;
+            for(BFOp& other : fn.ops){
+                saved |= other.type == BFOpType::SAVE && other.name == op.name;
+            }
+            if(!saved){
+                Diag()<<"bf++: error: ?restore "<<op.name<<" on line "<<ctx.tokens[op.pos].line<<" has no ?save "<<op.name<<" in "<<lbl<<std::endl;
+                ok = false;
+            }
+        }
+        if(CountedDepth(fn.ops) + names.size() > MAX_COUNTERS){
+            Diag()<<"bf++: error: "<<lbl<<" needs more than "<<MAX_COUNTERS<<" registers for its ?times loops and checkpoints"<<std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// broadcast constants and the startup check that the cpu has the vector instructions used
+std::ofstream& GenerateVectorSupport(ParsedContext& ctx, std::ofstream& file){
+    bool avx = ctx.vectorWidth == Widths::Ymm;
+    file<<'\t'<<".section .rodata"<<std::endl;
+    file<<'\t'<<AlignTo(5)<<std::endl;
+    for(int v = 0; v < 256; v++){
+        if(ctx.vectorConsts[v]){
+            file<<".Lbfpp_vec_"<<v<<':'<<std::endl;
+            file<<'\t'<<".fill 32, 1, "<<v<<std::endl;
+        }
+    }
+    file<<".Lbfpp_vec_msg:"<<std::endl;
+    file<<'\t'<<".ascii \"bf++: this program needs "<<(avx ? "AVX2" : "SSE4.1")<<"\\n\""<<std::endl;
+    file<<".Lbfpp_vec_msg_end:"<<std::endl;
+
+    file<<'\t'<<".text"<<std::endl;
+    file<<'\t'<<AlignTo(4)<<std::endl;
+    file<<"__bfpp_vector_check:"<<std::endl;
+    file<<'\t'<<GeneratePushRegister(ctx.regs.rbx, Widths::Qword)<<std::endl;
+    file<<'\t'<<"movl $1, %eax"<<std::endl;
+    file<<'\t'<<"cpuid"<<std::endl;
+    // SSE4.1 for ptest
+    file<<'\t'<<"testl $0x80000, %ecx"<<std::endl;
+    file<<'\t'<<"jz .Lbfpp_vec_fail"<<std::endl;
+    if(avx){
+        // OSXSAVE and AVX, the OS has to save the ymm state, then AVX2 itself
+        file<<'\t'<<"andl $0x18000000, %ecx"<<std::endl;
+        file<<'\t'<<"cmpl $0x18000000, %ecx"<<std::endl;
+        file<<'\t'<<"jne .Lbfpp_vec_fail"<<std::endl;
+        file<<'\t'<<"xorl %ecx, %ecx"<<std::endl;
+        file<<'\t'<<"xgetbv"<<std::endl;
+        file<<'\t'<<"andl $6, %eax"<<std::endl;
+        file<<'\t'<<"cmpl $6, %eax"<<std::endl;
+        file<<'\t'<<"jne .Lbfpp_vec_fail"<<std::endl;
+        file<<'\t'<<"movl $7, %eax"<<std::endl;
+        file<<'\t'<<"xorl %ecx, %ecx"<<std::endl;
+        file<<'\t'<<"cpuid"<<std::endl;
+        file<<'\t'<<"testl $0x20, %ebx"<<std::endl;
+        file<<'\t'<<"jz .Lbfpp_vec_fail"<<std::endl;
+    }
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::POP, Widths::Qword)<<' '<<GenerateRegisterOP(ctx.regs.rbx)<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::RET, Widths::Byte)<<std::endl;
+    file<<".Lbfpp_vec_fail:"<<std::endl;
+    file<<'\t'<<"movl $1, %eax"<<std::endl;
+    file<<'\t'<<"movl $"<<SYS_ERR<<", %edi"<<std::endl;
+    file<<'\t'<<"leaq .Lbfpp_vec_msg(%rip), %rsi"<<std::endl;
+    file<<'\t'<<"movl $.Lbfpp_vec_msg_end - .Lbfpp_vec_msg, %edx"<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::SYSCALL, Widths::Byte)<<std::endl;
+    // exit_group(1)
+    file<<'\t'<<"movl $231, %eax"<<std::endl;
+    file<<'\t'<<"movl $1, %edi"<<std::endl;
+    file<<'\t'<<GenerateInstruction(AssemblyInstruction::SYSCALL, Widths::Byte)<<std::endl;
+
+    file<<'\t'<<".section .init_array,\"aw\""<<std::endl;
+    file<<'\t'<<AlignTo(3)<<std::endl;
+    file<<'\t'<<".quad __bfpp_vector_check"<<std::endl;
+    ctx.initRoutines.push_back("__bfpp_vector_check");
+    return file;
+}
+
+// the constants float '+', '-' and '?mov' load
+std::ofstream& GenerateFloatData(ParsedContext& ctx, std::ofstream& file){
+    file<<'\t'<<".section .rodata"<<std::endl;
+    file<<'\t'<<AlignTo(3)<<std::endl;
+    // doubles first so every one stays 8 byte aligned
+    for(Widths width : {Widths::F64, Widths::F32}){
+        for(std::pair<Widths, uint64_t>& val : ctx.floatConsts){
+            if(val.first == width){
+                file<<GenerateFloatConstName(val.first, val.second)<<':'<<std::endl;
+                file<<'\t'<<(width == Widths::F32 ? ".long " : ".quad ")<<val.second<<std::endl;
+            }
+        }
+    }
+    return file;
+}
+
+// everything after the labels, the data and startup code the emitted functions asked for
+std::ofstream& GenerateTail(ParsedContext& ctx, std::ofstream& file){
+    if(ctx.partial.done){
+        GeneratePartialData(ctx, file);
+    }
+    if(!ctx.includes.empty()){
+        GenerateBinData(ctx, file);
+    }
+    if(!ctx.scans.empty()){
+        GenerateScanRoutines(ctx, file);
+    }
+    if(!ctx.floatConsts.empty()){
+        GenerateFloatData(ctx, file);
+    }
+    if(IsVectorWidth(ctx.vectorWidth)){
+        GenerateVectorSupport(ctx, file);
+    }
+    if(CHECKED_TAPE){
+        GenerateLineTable(ctx, file);
+    }
+    if(PROFILE_GENERATE){
+        GenerateProfileSupport(ctx, file);
+    }
+    if(FREESTANDING){
+        GenerateStart(ctx, file);
+    }
+    // nothing here needs an executable stack
+    file<<'\t'<<".section .note.GNU-stack,\"\",@progbits"<<std::endl;
+    return file;
+}
+
+bool BFPPCodegen(ParsedContext& ctx, const char* file_out){
+    std::vector<BFFunction> funcs = LowerParsed(ctx);
+    if(!CheckVectorOps(ctx, funcs) || !CheckFloatOps(ctx, funcs) || !CheckCountedLoops(ctx, funcs) || !CheckCheckpoints(ctx, funcs)){
+        return false;
+    }
+    PartialEvaluate(ctx, funcs);
+
+    std::ofstream file(file_out);
+    if(!file){
+        Diag()<<"Error opening file for codegen"<<std::endl;
+        return false;
+    }
+    
+    if(DEBUG_INFO){
+        file<<'\t'<<".file 1 \""<<EscapeString(ctx.sourcePath)<<'"'<<std::endl;
+    }
+
+    ApplyProfile(ctx, funcs);
+    InlineCalls(ctx, funcs);
+    MarkLive(ctx, funcs);
+    std::vector<size_t> order = LayoutOrder(ctx, funcs);
+    for(size_t f : order){
+        BFFunction& fn = funcs[f];
+        if(!fn.live){
+            continue;
+        }
+        UnrollCounted(fn);
+        LowerTailCalls(ctx, fn);
+        LowerScans(ctx, fn);
+        AllocateCounters(fn, ctx.labels[fn.label]);
+        SizeFrame(fn, ctx.labels[fn.label]);
+    }
+    ComputeClobbers(ctx, funcs);
+    for(size_t f : order){
+        if(funcs[f].live){
+            AnalyzeRegisters(ctx, funcs[f]);
+        }
+    }
+    FoldIdentical(ctx, funcs, order);
+
+    GenerateTextSectionGAS(file)<<'\n';
+
+    GenerateGlobals(ctx, funcs, file)<<'\n';
+    GenerateExterns(ctx, file)<<'\n';
+
+    for(size_t f : order){
+        if(funcs[f].live && !funcs[f].folded){
+            GenerateFunction(ctx, funcs[f], file);
+        }
+    }
+    GenerateTail(ctx, file);
+    if(STATS){
+        PrintFrameStats(ctx, funcs);
+        if(ctx.profile.loaded){
+            PrintLayoutStats(ctx, funcs, order);
+        }
+        if(ctx.partial.done){
+            PrintPartialStats(ctx);
+        }
+        PrintSelectionStats(ctx);
+        PrintArenaStats(ctx);
+    }
+
+    file.close();
+    return true;
+}
+
+// --stream reads, parses and compiles the source one label at a time and writes every label out before
+// it reads the next, so memory follows the largest label and not the file. The program only keeps
+// what the tail and the link step need, anything that looks at several labels at once (inlining,
+// dropping and folding labels, call clobbers, the partial evaluator, profiles) is skipped
+
+// the source from one '@' up to the next, an '@' in a comment or a quoted path does not start a label
+bool ReadLabelSource(std::istream& in, std::string& chunk, size_t& lines){
+    std::streambuf* buf = in.rdbuf();
+    chunk.clear();
+    lines = 0;
+    bool comment = false, quoted = false;
+    for(int c = buf->sgetc(); c != std::char_traits<char>::eof(); c = buf->snextc()){
+        if(c == '@' && !comment && !quoted && !chunk.empty()){
+            break;
+        }
+        if(c == '\n'){
+            lines++;
+            comment = false;
+            quoted = false;
+        }
+        else if(c == ';'){
+            comment = true;
+        }
+        else if(c == '"' && !comment){
+            quoted = !quoted;
+        }
+        chunk.push_back((char)c);
+    }
+    return !chunk.empty();
+}
+
+// a copy in the program's arena, the chunk it came from is freed before the compile ends
+inline std::string_view KeepString(Arena& arena, std::string_view str){
+    char* out = (char*)arena.Allocate(str.size(), 1);
+    std::memcpy(out, str.data(), str.size());
+    return std::string_view(out, str.size());
+}
+
+inline size_t KeepToken(ParsedContext& prog, Tokenizer::Token& tok){
+    prog.tokens.emplace_back(KeepString(prog.arena, tok.val), tok.line, tok.type);
+    return prog.tokens.size() - 1;
+}
+
+// the tables codegen fills for the whole program move into the chunk being compiled and back out
+inline void SwapProgramTables(ParsedContext& a, ParsedContext& b){
+    std::swap(a.ioLoops, b.ioLoops);
+    std::swap(a.vectorWidth, b.vectorWidth);
+    std::swap(a.vectorConsts, b.vectorConsts);
+    a.floatConsts.swap(b.floatConsts);
+    a.scans.swap(b.scans);
+    a.lineMarks.swap(b.lineMarks);
+    std::swap(a.selectRewrites, b.selectRewrites);
+    std::swap(a.selectSaved, b.selectSaved);
+}
+
+// what the checks and the link step look at once every label is out
+void KeepProgramTables(ParsedContext& prog, ParsedContext& ctx){
+    for(Label& lbl : ctx.labels){
+        prog.labels.emplace_back(KeepString(prog.arena, lbl.Name), 0, lbl.ptrl, lbl.type);
+    }
+    for(std::string_view ext : ctx.externs){
+        if(std::find(prog.externs.begin(), prog.externs.end(), ext) == prog.externs.end()){
+            prog.externs.push_back(KeepString(prog.arena, ext));
+        }
+    }
+    for(Call& sp : ctx.spawns){
+        size_t pos = KeepToken(prog, ctx.tokens[sp.pos]);
+        prog.spawns.emplace_back(pos, prog.tokens[pos].val);
+    }
+    for(size_t join : ctx.joins){
+        prog.joins.push_back(KeepToken(prog, ctx.tokens[join]));
+    }
+    for(BinInclude& inc : ctx.includes){
+        prog.includes.emplace_back(KeepString(prog.arena, inc.name), KeepString(prog.arena, inc.path), inc.line);
+    }
+    for(BinUse& use : ctx.binUses){
+        size_t pos = KeepToken(prog, ctx.tokens[use.pos]);
+        prog.binUses.emplace_back(pos, prog.tokens[pos].val, use.reg);
+    }
+    // the link step only asks whether float cells are used at all
+    for(WidthSwitch& sw : ctx.switches){
+        if(IsFloatWidth(sw.to) && prog.switches.empty()){
+            prog.switches.push_back(sw);
+        }
+    }
+}
+
+bool BFPPCodegenStream(ParsedContext& prog, std::istream& in, std::ofstream& file){
+    if(DEBUG_INFO){
+        file<<'\t'<<".file 1 \""<<EscapeString(prog.sourcePath)<<'"'<<std::endl;
+    }
+    GenerateTextSectionGAS(file)<<'\n';
+
+    std::string chunk;
+    size_t line = 1, lines = 0, loops = 0, largest = 0, arenaBytes = 0;
+    Widths width = Widths::Byte;
+    double step = 1.0;
+    while(ReadLabelSource(in, chunk, lines)){
+        largest = std::max(largest, chunk.size());
+        RemoveLineComments(chunk, ';');
+        Arena arena;
+        ArenaVector<Tokenizer::Token> toks = Tokenizer::Tokenize(chunk, arena);
+        ClassifyTokens(toks, prog.bfpp);
+        long long depth = 0;
+        for(Tokenizer::Token& tok : toks){
+            tok.line += line - 1;
+            if(tok.type == Tokenizer::TokenType::T_LSQUARE){
+                depth++;
+            }
+            else if(tok.type == Tokenizer::TokenType::T_RSQUARE && --depth < 0){
+                break;
+            }
+        }
+        if(depth != 0){
+            Diag()<<"bf++: error: --stream needs every loop to end inside its label, the label on line "<<line<<" does not"<<std::endl;
+            return false;
+        }
+
+        ParsedContext ctx(arena, toks, prog.bfpp, prog.regs);
+        // widths and steps carry over from the labels before, like they do in one piece
+        ctx.switches.emplace_back(width, 0);
+        ctx.steps.emplace_back(step, 0);
+        ParseTokens(ctx);
+        if(ctx.parseFailed){
+            return false;
+        }
+        width = ParsedWidth(ctx);
+        step = ctx.steps.back().step;
+
+        // the ?bin names are checked once every ?include_bin is known, the registers have to be right now
+        for(BinUse& use : ctx.binUses){
+            if(!CheckBinRegister(ctx, use)){
+                return false;
+            }
+        }
+        std::vector<BFFunction> funcs = LowerParsed(ctx);
+        if(!CheckVectorOps(ctx, funcs) || !CheckFloatOps(ctx, funcs) || !CheckCountedLoops(ctx, funcs) || !CheckCheckpoints(ctx, funcs)){
+            return false;
+        }
+        SwapProgramTables(ctx, prog);
+        for(BFFunction& fn : funcs){
+            // loops are numbered per chunk, their labels have to be unique in the whole file
+            for(BFOp& op : fn.ops){
+                if(op.type == BFOpType::LOOP_START || op.type == BFOpType::LOOP_END){
+                    op.target += loops;
+                }
+            }
+            UnrollCounted(fn);
+            LowerTailCalls(ctx, fn);
+            LowerScans(ctx, fn);
+            AllocateCounters(fn, ctx.labels[fn.label]);
+            SizeFrame(fn, ctx.labels[fn.label]);
+            AnalyzeRegisters(ctx, fn);
+        }
+        loops += ctx.done_loops.size();
+
+        GenerateGlobals(ctx, funcs, file);
+        GenerateExterns(ctx, file);
+        size_t marks = ctx.lineMarks.size();
+        for(BFFunction& fn : funcs){
+            GenerateFunction(ctx, fn, file);
+        }
+        // the line table names labels by their index in the whole program
+        for(size_t i = marks; i < ctx.lineMarks.size(); i++){
+            ctx.lineMarks[i].label += prog.labels.size();
+        }
+        SwapProgramTables(ctx, prog);
+        KeepProgramTables(prog, ctx);
+        arenaBytes = std::max(arenaBytes, arena.bytes);
+        line += lines;
+    }
+    if(STATS){
+        Report()<<"stream: "<<prog.labels.size()<<" labels, the largest "<<largest<<" bytes of source and "<<arenaBytes<<" frontend arena bytes"<<std::endl;
+        PrintSelectionStats(prog);
+    }
+    return true;
+}
+
+// C backend, every label becomes a function over its own tape and the argument registers
+// become the parameters r1..rK, so the system compiler sees the whole program
+
+inline const char* GetCType(Widths width){
+    switch(width){
+        case Widths::Byte:
+            return "uint8_t";
+        case Widths::Word:
+            return "uint16_t";
+        case Widths::Dword:
+            return "uint32_t";
+        case Widths::F32:
+            return "float";
+        case Widths::F64:
+            return "double";
+        default:
+            return "uint64_t";
+    }
+}
+
+inline std::string GetCName(std::string_view name){
+    // main gets a C main wrapper, the label itself is renamed
+    if(name == "main"){
+        return "bfpp_label_main";
+    }
+    return std::string(name);
+}
+
+// externs are declared under a name of their own that the assembler maps back to theirs,
+// a prototype in the libc name would clash with the C compiler's builtin one for putchar, write and so on
+inline std::string GetCExternName(std::string_view name){
+    return "bfpp_extern_" + std::string(name);
+}
+
+// what a ?call or ?spawn of name calls in C
+inline std::string GetCCallee(ParsedContext& ctx, std::string_view name){
+    for(Label& lbl : ctx.labels){
+        if(lbl.Name == name){
+            return GetCName(name);
+        }
+    }
+    return GetCExternName(name);
+}
+
+inline std::string GenerateCLoad(Widths width){
+    return std::string("bfpp_ld") + (IsFloatWidth(width) ? "f" : "") + std::to_string(GetMultiplier(width) * 8) + "(p)";
+}
+
+inline std::string GenerateCStore(Widths width, const std::string& val){
+    return std::string("bfpp_st") + (IsFloatWidth(width) ? "f" : "") + std::to_string(GetMultiplier(width) * 8) + "(p, (" + GetCType(width) + ")(" + val + "));";
+}
+
+// float constants go in as their bits, so every one comes out exactly like the native backend's
+inline std::string GenerateCFloat(Widths width, uint64_t bits){
+    std::stringstream out;
+    out<<"bfpp_f"<<GetMultiplier(width) * 8<<"(0x"<<std::hex<<bits<<(width == Widths::F32 ? "u)" : "ull)");
+    return out.str();
+}
+
+// r1..rK, or the given values padded with zeros
+inline std::string GenerateCArgs(unsigned int regCount, std::vector<std::string> vals = {}){
+    std::string out;
+    for(unsigned int r = 1; r <= regCount; r++){
+        if(r > 1){
+            out += ", ";
+        }
+        if(vals.empty()){
+            out += "r" + std::to_string(r);
+        }
+        else{
+            out += r <= vals.size() ? vals[r - 1] : "0";
+        }
+    }
+    return out;
+}
+
+inline std::string GenerateCParams(unsigned int regCount, bool names){
+    std::string out;
+    for(unsigned int r = 1; r <= regCount; r++){
+        if(r > 1){
+            out += ", ";
+        }
+        out += "long";
+        if(names){
+            out += " r" + std::to_string(r);
+        }
+    }
+    return out;
+}
+
+std::ofstream& GenerateCHeader(ParsedContext& ctx, std::vector<BFFunction>& funcs, unsigned int regCount, std::ofstream& file){
+    file<<"/* generated by bf++ */"<<std::endl;
+    file<<"#include <stdint.h>"<<std::endl<<std::endl;
+    for(int bits = 8; bits <= 64; bits *= 2){
+        file<<"static inline uint"<<bits<<"_t bfpp_ld"<<bits<<"(const unsigned char* p){ uint"<<bits<<"_t v; __builtin_memcpy(&v, p, sizeof v); return v; }"<<std::endl;
+        file<<"static inline void bfpp_st"<<bits<<"(unsigned char* p, uint"<<bits<<"_t v){ __builtin_memcpy(p, &v, sizeof v); }"<<std::endl;
+    }
+    file<<"static inline int bfpp_any(const unsigned char* p, int n){ unsigned char v = 0; for(int i = 0; i < n; i++) v |= p[i]; return v != 0; }"<<std::endl;
+    bool floats = false;
+    for(BFFunction& fn : funcs){
+        for(BFOp& op : fn.ops){
+            floats |= IsFloatWidth(op.width);
+        }
+    }
+    if(floats){
+        // a float cell loop runs while the cell is ordered and not zero, like the native ucomiss test
+        for(int bits = 32; bits <= 64; bits *= 2){
+            const char* type = bits == 32 ? "float" : "double";
+            file<<"static inline "<<type<<" bfpp_ldf"<<bits<<"(const unsigned char* p){ "<<type<<" v; __builtin_memcpy(&v, p, sizeof v); return v; }"<<std::endl;
+            file<<"static inline void bfpp_stf"<<bits<<"(unsigned char* p, "<<type<<" v){ __builtin_memcpy(p, &v, sizeof v); }"<<std::endl;
+            file<<"static inline "<<type<<" bfpp_f"<<bits<<"(uint"<<bits<<"_t b){ "<<type<<" v; __builtin_memcpy(&v, &b, sizeof v); return v; }"<<std::endl;
+            file<<"static inline int bfpp_nzf"<<bits<<"(const unsigned char* p){ "<<type<<" v = bfpp_ldf"<<bits<<"(p); return v < 0 || v > 0; }"<<std::endl;
+        }
+    }
+    file<<std::endl;
+
+    // externs take every register, '.' and ?write go through write, ?read through read
+    std::vector<std::string_view> externs;
+    for(std::string_view ext : ctx.externs){
+        bool internal = false;
+        for(Label& lbl : ctx.labels){
+            internal |= lbl.Name == ext;
+        }
+        if(!internal){
+            externs.push_back(ext);
+        }
+    }
+    if(std::find(externs.begin(), externs.end(), "write") == externs.end()){
+        externs.push_back("write");
+    }
+    bool reads = false;
+    for(BlockIO& io : ctx.io){
+        reads |= io.read;
+    }
+    if(reads && std::find(externs.begin(), externs.end(), "read") == externs.end()){
+        externs.push_back("read");
+    }
+    for(std::string_view ext : externs){
+        file<<"long "<<GetCExternName(ext)<<'('<<GenerateCParams(regCount, false)<<") __asm__(\""<<ext<<"\");"<<std::endl;
+    }
+    if(!ctx.spawns.empty() || !ctx.joins.empty()){
+        file<<"void __bfpp_spawn_task(const uint64_t* regs);"<<std::endl;
+        file<<"uint64_t __bfpp_join(void);"<<std::endl;
+    }
+    // C has no portable way to embed a file, the assembler includes it like in the native backend
+    for(size_t i = 0; i < ctx.includes.size(); i++){
+        std::string name = "bfpp_bin_" + std::string(ctx.includes[i].name);
+        file<<"__asm__(\".section .rodata\\n\\t.p2align 6\\n"<<name<<":\\n\\t.incbin \\\""<<EscapeString(EscapeString(ctx.includePaths[i]))<<"\\\"\\n\\t.previous\");"<<std::endl;
+        file<<"extern const unsigned char "<<name<<"[] __attribute__((visibility(\"hidden\")));"<<std::endl;
+    }
+    for(BFFunction& fn : funcs){
+        Label& lbl = ctx.labels[fn.label];
+        file<<(lbl.Name == "main" ? "static " : "")<<"long "<<GetCName(lbl.Name)<<'('<<GenerateCParams(regCount, false)<<");"<<std::endl;
+    }
+    file<<std::endl;
+    return file;
+}
+
+// -g maps every statement back to the line of its op
+inline void GenerateCLine(ParsedContext& ctx, BFOp& op, std::ofstream& file){
+    if(DEBUG_INFO && op.pos < ctx.tokens.size()){
+        file<<"#line "<<ctx.tokens[op.pos].line<<" \""<<EscapeString(ctx.sourcePath)<<'"'<<std::endl;
+    }
+}
+
+bool GenerateCFunction(ParsedContext& ctx, BFFunction& fn, unsigned int regCount, std::ofstream& file){
+    Label& func = ctx.labels[fn.label];
+    if(!fn.structured){
+        Diag()<<"bf++: error: the C backend needs every loop of "<<func<<" to stay inside it"<<std::endl;
+        return false;
+    }
+    if(ctx.profile.loaded && (fn.weight == 0 || fn.hot)){
+        file<<(fn.weight == 0 ? "__attribute__((cold)) " : "__attribute__((hot)) ");
+    }
+    file<<(func.Name == "main" ? "static " : "")<<"long "<<GetCName(func.Name)<<'('<<GenerateCParams(regCount, true)<<"){"<<std::endl;
+    // the tape's address escapes into write, so the C compiler cannot turn a call of the label itself into a jump,
+    // it jumps back here instead and the declaration below zeroes a fresh tape
+    bool selfTail = std::any_of(fn.ops.begin(), fn.ops.end(), [&func](BFOp& op){
+        return op.type == BFOpType::TAIL_CALL && op.name == func.Name;
+    });
+    if(selfTail){
+        file<<"bfpp_restart: ;"<<std::endl;
+    }
+    file<<"    unsigned char tape["<<func.frameAlloc<<"] = {0};"<<std::endl;
+    file<<"    unsigned char* p = tape + "<<BASE_OFFSET<<';'<<std::endl;
+    std::vector<std::string_view> checkpoints = CheckpointNames(fn.ops);
+    for(size_t k = 0; k < checkpoints.size(); k++){
+        file<<"    unsigned char* k"<<k<<" = p; /* ?save "<<checkpoints[k]<<" */"<<std::endl;
+    }
+
+    std::string indent = "    ";
+    for(BFOp& op : fn.ops){
+        GenerateCLine(ctx, op, file);
+        Widths width = op.width;
+        int bytes = GetMultiplier(width);
+        bool vector = IsVectorWidth(width);
+        std::string line;
+        bool floatValue = op.type == BFOpType::ARGUMENT || op.type == BFOpType::GETARG || op.type == BFOpType::CALL ||
+            (op.type == BFOpType::RET && ctx.labels[op.target].type != Keyword::Void);
+        if(IsFloatWidth(width) && floatValue){
+            // the parameters are the integer registers, there is nothing to carry xmm0-7
+            Diag()<<"bf++: error: passing float cells needs the assembly backend, on line "<<ctx.tokens[op.pos].line<<std::endl;
+            return false;
+        }
+        switch(op.type){
+            case BFOpType::LOOP_START:
+                if(op.counted){
+                    std::string counter = "c" + std::to_string(op.target);
+                    std::string count = op.fromCell ? "(uint64_t)" + GenerateCLoad(width) : std::to_string((unsigned long long)op.val) + "ull";
+                    line = "for(uint64_t " + counter + " = " + count + "; " + counter + "; " + counter + "--){";
+                }
+                else if(vector){
+                    line = "while(bfpp_any(p, " + std::to_string(bytes) + ")){";
+                }
+                else if(IsFloatWidth(width)){
+                    line = "while(bfpp_nzf" + std::to_string(bytes * 8) + "(p)){";
+                }
+                else{
+                    line = "while(" + GenerateCLoad(width) + "){";
+                }
+                file<<indent<<line<<std::endl;
+                indent += "    ";
+                continue;
+            case BFOpType::LOOP_END:
+                indent.resize(indent.size() - 4);
+                line = "}";
+                break;
+            case BFOpType::PLUS:
+            case BFOpType::MINUS:
+                if(vector){
+                    line = "for(int l = 0; l < " + std::to_string(bytes) + "; l++) p[l] " + (op.type == BFOpType::PLUS ? "+= " : "-= ");
+                    line += std::to_string(op.count & 0xFF) + ';';
+                }
+                else if(IsFloatWidth(width)){
+                    line = GenerateCStore(width, GenerateCLoad(width) + (op.type == BFOpType::PLUS ? " + " : " - ") + GenerateCFloat(width, op.val));
+                }
+                else{
+                    line = GenerateCStore(width, GenerateCLoad(width) + (op.type == BFOpType::PLUS ? " + " : " - ") + std::to_string(op.count) + 'u');
+                }
+                break;
+            case BFOpType::MOV:
+                if(vector){
+                    line = "for(int l = 0; l < " + std::to_string(bytes) + "; l++) p[l] = " + std::to_string(op.val & 0xFF) + ';';
+                }
+                else if(IsFloatWidth(width)){
+                    line = GenerateCStore(width, GenerateCFloat(width, op.val));
+                }
+                else{
+                    line = GenerateCStore(width, std::to_string((unsigned long long)op.val) + "ull");
+                }
+                break;
+            case BFOpType::LEFT:
+                line = "p -= " + std::to_string((long long)op.count * bytes) + ';';
+                break;
+            case BFOpType::RIGHT:
+                line = "p += " + std::to_string((long long)op.count * bytes) + ';';
+                break;
+            case BFOpType::OUTPUT:
+                for(unsigned int c = 0; c < op.count; c++){
+                    if(c > 0){
+                        GenerateCLine(ctx, op, file);
+                    }
+                    file<<indent<<GetCExternName("write")<<'('<<GenerateCArgs(regCount, {"1", "(long)(uintptr_t)p", "1"})<<");"<<std::endl;
+                }
+                continue;
+            case BFOpType::ARGUMENT:{
+                std::string reg = "r" + std::to_string(op.count);
+                if(op.address){
+                    line = reg + " = (long)(uintptr_t)p;";
+                }
+                else if(width == Widths::Byte || width == Widths::Word){
+                    // narrow register writes keep the upper bits like the native backend
+                    std::string mask = width == Widths::Byte ? "0xFFl" : "0xFFFFl";
+                    line = reg + " = (" + reg + " & ~" + mask + ") | (long)" + GenerateCLoad(width) + ';';
+                }
+                else{
+                    line = reg + " = (long)" + GenerateCLoad(width) + ';';
                 }
-                file<<"\t#\t";
-                GenerateInstructionComment(file, ins);
-                file<<std::endl;
+                break;
             }
-        }
-        for(size_t r = 0; r < retsize; r++){
-            FReturn& ret = ctx.rets[r];
-            if(ret.pos == i){
-                Label& lbl = ctx.labels[ret.label];
-                if(lbl.type != Keyword::Void){
-                    UnsyncRegister(ctx.regs.rax);
-                    file<<'\t';
-                    file<<GenerateInstruction(AssemblyInstruction::MOV, currentWidth)<<' ';
-                    file<<GenerateMemRegisterOP(ctx.regs.frameReg)<<", %"<<GetRegisterWidth(ctx.regs.rax, currentWidth);
-                    file<<std::endl;
+            case BFOpType::GETARG:{
+                std::string reg = "r" + std::to_string(op.count);
+                if(op.count > regCount){
+                    Diag()<<"Accepting stack arguments isnt available currently"<<std::endl;
+                    continue;
+                }
+                if(op.address){
+                    line = "p = (unsigned char*)(uintptr_t)" + reg + ';';
+                }
+                else{
+                    line = GenerateCStore(width, reg);
                 }
-                file<<'\t'<<GetUJumpSyntax()<<' ';
-                GenerateLabelEndName(lbl, file)<<std::endl;
+                break;
             }
-        }
-        for(size_t l = 0; l < lblsize; l++){
-            Label& lbl = ctx.labels[l];
-            if(i == lbl.end){
-                if(lbl.end != 0){
-                    GenerateLabelEnd(lbl, file);
-                    GenerateEpilogue(ctx, file, lbl)<<std::endl;
+            case BFOpType::CALL:
+                line = GenerateCStore(width, GetCCallee(ctx, op.name) + '(' + GenerateCArgs(regCount) + ')');
+                break;
+            case BFOpType::TAIL_CALL:
+                // the callee's value is returned as it is, like the native jump does
+                if(op.name == func.Name){
+                    line = "goto bfpp_restart;";
                 }
                 else{
-                    labelEnd = true;
-                    labelEndIndex = l;
+                    line = "return " + GetCCallee(ctx, op.name) + '(' + GenerateCArgs(regCount) + ");";
                 }
+                break;
+            case BFOpType::SPAWN:
+                line = "{ uint64_t regs[7] = {" + GenerateCArgs(6) + ", (uint64_t)(uintptr_t)&" + GetCName(op.name) + "}; __bfpp_spawn_task(regs); }";
+                break;
+            case BFOpType::JOIN:
+                line = GenerateCStore(width, "__bfpp_join()");
+                break;
+            case BFOpType::WRITE:
+            case BFOpType::READ:{
+                if(op.count == 0){
+                    continue;
+                }
+                std::string call = GetCExternName(op.type == BFOpType::WRITE ? "write" : "read");
+                std::string fd = op.type == BFOpType::WRITE ? std::to_string(SYS_OUT) : std::to_string(SYS_IN);
+                line = "{ unsigned char* b = p; long n = " + std::to_string((unsigned long long)op.count * bytes) + "; ";
+                line += "while(n > 0){ long k = " + call + '(' + GenerateCArgs(regCount, {fd, "(long)(uintptr_t)b", "n"}) + "); ";
+                line += "if(k <= 0) break; b += k; n -= k; } }";
+                break;
             }
-            else if(i == lbl.pos){
-                file<<'\t'<<AlignTo(4)<<std::endl;
-                GenerateLabelName(lbl, file)<<":\n";
-                GeneratePrologue(ctx, file)<<std::endl;
+            case BFOpType::SAVE:
+            case BFOpType::RESTORE:{
+                std::string checkpoint = "k" + std::to_string(std::find(checkpoints.begin(), checkpoints.end(), op.name) - checkpoints.begin());
+                line = op.type == BFOpType::SAVE ? checkpoint + " = p;" : "p = " + checkpoint + ';';
+                break;
             }
+            case BFOpType::BIN:
+                if(op.count == 0){
+                    line = "p = (unsigned char*)bfpp_bin_" + std::string(op.name) + ';';
+                }
+                else{
+                    line = "r" + std::to_string(op.count) + " = (long)(uintptr_t)bfpp_bin_" + std::string(op.name) + ';';
+                }
+                break;
+            case BFOpType::RET:
+                if(ctx.labels[op.target].type == Keyword::Void){
+                    line = "return 0;";
+                }
+                else{
+                    line = "return (long)" + GenerateCLoad(width) + ';';
+                }
+                break;
+            default:
+                continue;
         }
+        file<<indent<<line<<std::endl;
     }
-
-    if(labelEnd){
-        Label& lbl = ctx.labels[labelEndIndex];
-        GenerateLabelEnd(lbl, file);
-        GenerateEpilogue(ctx, file, lbl)<<std::endl;
-    }
-
-    file.close();
+    file<<"    return 0;"<<std::endl;
+    file<<'}'<<std::endl<<std::endl;
+    return true;
 }
 
-void RemoveLineComments(std::string& str, char symb){
-    size_t len = str.size();
-
-    bool incom = false;
-    for(size_t i = 0; i < len; i++){
-
-        if(str[i] == '\n') incom = false;
+bool BFPPCodegenC(ParsedContext& ctx, const char* file_out){
+    if(CHECKED_TAPE){
+        Diag()<<"bf++: error: --checked-tape needs the assembly backend"<<std::endl;
+        return false;
+    }
+    if(PROFILE_GENERATE){
+        Diag()<<"bf++: error: --profile-generate needs the assembly backend, C output can use the C compiler's own profiling"<<std::endl;
+        return false;
+    }
+    std::vector<BFFunction> funcs = LowerParsed(ctx);
+    if(!CheckVectorOps(ctx, funcs) || !CheckFloatOps(ctx, funcs) || !CheckCountedLoops(ctx, funcs) || !CheckCheckpoints(ctx, funcs)){
+        return false;
+    }
+    // a profile only becomes hints, the C compiler does the layout
+    ApplyProfile(ctx, funcs);
+    MarkLive(ctx, funcs);
+    // stack arguments just become more parameters
+    unsigned int regCount = 6;
+    for(BFFunction& fn : funcs){
+        for(BFOp& op : fn.ops){
+            if(op.type == BFOpType::ARGUMENT){
+                regCount = std::max(regCount, op.count);
+            }
+        }
+        LowerTailCalls(ctx, fn);
+        SizeFrame(fn, ctx.labels[fn.label]);
+    }
 
-        if(incom){
-            str[i] = ' ';
+    std::ofstream file(file_out);
+    if(!file){
+        Diag()<<"Error opening file for codegen"<<std::endl;
+        return false;
+    }
+    GenerateCHeader(ctx, funcs, regCount, file);
+    bool hasMain = false;
+    for(BFFunction& fn : funcs){
+        if(!fn.live){
+            continue;
         }
-        else{
-            if(str[i] == symb){
-                incom = true;
-                str[i] = ' ';
-            }
+        if(!GenerateCFunction(ctx, fn, regCount, file)){
+            return false;
         }
+        hasMain |= ctx.labels[fn.label].Name == "main";
+    }
+    if(hasMain){
+        file<<"int main(int argc, char** argv, char** envp){"<<std::endl;
+        file<<"    return (int)bfpp_label_main("<<GenerateCArgs(regCount, {"argc", "(long)(uintptr_t)argv", "(long)(uintptr_t)envp"})<<");"<<std::endl;
+        file<<'}'<<std::endl;
     }
+    if(STATS){
+        PrintFrameStats(ctx, funcs);
+        PrintArenaStats(ctx);
+    }
+    file.close();
+    return true;
 }
 
 std::string GetFileExtension(std::string& fileName){
@@ -1062,12 +5337,15 @@ std::string GetFileExtension(std::string& fileName){
 
     for(size_t i = 0; i < fileName.length(); i++){
         if(fileName[i] == '.') dotCount++;
+        // dots of directories are not extensions
+        if(fileName[i] == '/') dotCount = 0;
     }
     if(dotCount == 0){
         return "";
     }
     std::string ext;
-    for(size_t i = 0; i < fileName.length(); i++){
+    size_t slash = fileName.find_last_of('/');
+    for(size_t i = slash == std::string::npos ? 0 : slash + 1; i < fileName.length(); i++){
         if(fileName[i] == '.') dotCount--;
         if(dotCount == 0){
             ext += fileName[i];
@@ -1093,102 +5371,339 @@ void RemoveFileExtension(std::string& str){
 enum class FileType{
     Assembly,
     Object,
+    C,
+    Executable,
 };
 
+// the runtime library is built next to the compiler
+std::string GetRuntimeDir(const char* argv0){
+    std::string dir = argv0;
+    size_t slash = dir.find_last_of('/');
+    if(slash == std::string::npos){
+        return ".";
+    }
+    return dir.substr(0, slash);
+}
+
 enum class CLIState{
     Normal,
     Output,
     Assembler,
     Offset,
     Allocate,
+    Inline,
+    Server,
+    Client,
+    ProfileUse,
+    PartialEval,
+    Unroll,
+    Export,
 };
 
-int main(int argc, char** argv){
-    if(argc <= 1){
-        std::cerr<<"bf++: error: no input files"<<std::endl;
-        return 1;
-    }
+// one compile, from the command line or a server request
+struct CompileJob{
     std::string input;
     std::string output;
-    FileType type = FileType::Assembly;
+    std::string ext;
     std::string assembler;
+    std::string socket; // --server/--client path
+    bool serve = false;
+    bool client = false;
+    FileType type = FileType::Assembly;
+};
+
+// a non-negative number that fits T, anything else is an error instead of an exception,
+// a server request must not be able to take the whole server down
+template<typename T>
+bool ParseOptionNumber(const std::string& option, const std::string& arg, T& out){
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(arg.c_str(), &end, 0);
+    if(arg.empty() || arg[0] == '-' || *end != '\0' || errno == ERANGE ||
+       value > (unsigned long long)std::numeric_limits<T>::max()){
+        Diag()<<"bf++: error: "<<option<<" expects a number, got '"<<arg<<"'"<<std::endl;
+        return false;
+    }
+    out = (T)value;
+    return true;
+}
+
+// fills the job and this thread's options
+bool ParseArguments(std::vector<std::string>& args, CompileJob& job){
     CLIState state = CLIState::Normal;
 
-    for(int i = 1; i < argc; i++){
+    for(size_t i = 0; i < args.size(); i++){
+        std::string& arg = args[i];
         if(state == CLIState::Normal){
-            if((argv[i])[0] == '-'){
-                std::string flag = argv[i];
-                if(flag == "-o"){
+            if(!arg.empty() && arg[0] == '-'){
+                if(arg == "-o"){
                     state = CLIState::Output;
                 }
-                else if(flag == "-a" || flag == "--assembler"){
+                else if(arg == "-a" || arg == "--assembler"){
                     state = CLIState::Assembler;
                 }
-                else if(flag == "--offset"){
+                else if(arg == "--offset"){
                     state = CLIState::Offset;
                 }
-                else if(flag == "--stack"){
+                else if(arg == "--stack"){
                     state = CLIState::Allocate;
                 }
+                else if(arg == "--inline-threshold"){
+                    state = CLIState::Inline;
+                }
+                else if(arg == "--stats"){
+                    STATS = true;
+                }
+                else if(arg == "--checked-tape"){
+                    CHECKED_TAPE = true;
+                }
+                else if(arg == "-g"){
+                    DEBUG_INFO = true;
+                }
+                else if(arg == "--partial-eval"){
+                    state = CLIState::PartialEval;
+                }
+                else if(arg == "--unroll"){
+                    state = CLIState::Unroll;
+                }
+                else if(arg == "--export"){
+                    state = CLIState::Export;
+                }
+                else if(arg == "--profile-generate"){
+                    PROFILE_GENERATE = true;
+                }
+                else if(arg == "--profile-use"){
+                    state = CLIState::ProfileUse;
+                }
+                else if(arg == "--stream"){
+                    STREAM = true;
+                }
+                else if(arg == "--server"){
+                    state = CLIState::Server;
+                }
+                else if(arg == "--client"){
+                    state = CLIState::Client;
+                }
             }
             else{
-                input = argv[i];
+                job.input = arg;
             }
         }
         else if(state == CLIState::Assembler){
-            assembler = argv[i];
+            job.assembler = arg;
             state = CLIState::Normal;
         }
         else if(state == CLIState::Output){
-            output = argv[i];
+            job.output = arg;
             state = CLIState::Normal;
         }
         else if(state == CLIState::Allocate){
-            ALLOCATE = std::stoul(argv[i]);
+            if(!ParseOptionNumber("--stack", arg, ALLOCATE)){
+                return false;
+            }
             state = CLIState::Normal;
         }
         else if(state == CLIState::Offset){
-            BASE_OFFSET = std::stoul(argv[i]);
+            if(!ParseOptionNumber("--offset", arg, BASE_OFFSET)){
+                return false;
+            }
+            state = CLIState::Normal;
+        }
+        else if(state == CLIState::Inline){
+            if(!ParseOptionNumber("--inline-threshold", arg, INLINE_THRESHOLD)){
+                return false;
+            }
+            state = CLIState::Normal;
+        }
+        else if(state == CLIState::PartialEval){
+            if(!ParseOptionNumber("--partial-eval", arg, PARTIAL_EVAL)){
+                return false;
+            }
+            state = CLIState::Normal;
+        }
+        else if(state == CLIState::Unroll){
+            if(!ParseOptionNumber("--unroll", arg, UNROLL)){
+                return false;
+            }
+            if(UNROLL > UNROLL_MAX){
+                Diag()<<"bf++: warning: --unroll "<<UNROLL<<" is more than "<<UNROLL_MAX<<", using "<<UNROLL_MAX<<std::endl;
+                UNROLL = UNROLL_MAX;
+            }
+            state = CLIState::Normal;
+        }
+        else if(state == CLIState::Export){
+            EXPORTS.push_back(arg);
+            state = CLIState::Normal;
+        }
+        else if(state == CLIState::ProfileUse){
+            PROFILE_USE = arg;
+            state = CLIState::Normal;
+        }
+        else if(state == CLIState::Server || state == CLIState::Client){
+            job.socket = arg;
+            job.serve = state == CLIState::Server;
+            job.client = state == CLIState::Client;
             state = CLIState::Normal;
         }
     }
-    std::string ext = GetFileExtension(output);
-    std::transform(ext.begin(), ext.end(), ext.begin(),
+    if(job.serve){
+        return true;
+    }
+    job.ext = GetFileExtension(job.output);
+    std::transform(job.ext.begin(), job.ext.end(), job.ext.begin(),
     [](unsigned char c){return std::tolower(c);});
     
-    RemoveFileExtension(output);
+    RemoveFileExtension(job.output);
     
-    if(ext == ".s" || ext == ".asm"){
-        type = FileType::Assembly;
+    if(job.ext == ".s" || job.ext == ".asm"){
+        job.type = FileType::Assembly;
+    }
+    else if(job.ext == ".o" || job.ext == ".obj"){
+        job.type = FileType::Object;
     }
-    else if(ext == ".o" || ext == ".obj"){
-        type = FileType::Object;
+    else if(job.ext == ".c"){
+        job.type = FileType::C;
+    }
+    else if(job.ext.empty() && !job.output.empty()){
+        job.type = FileType::Executable;
     }
     else{
-        std::cerr<<"bf++: error: Unknown file extension"<<std::endl;
-        return 1;
+        Diag()<<"bf++: error: Unknown file extension"<<std::endl;
+        return false;
     }
+    return true;
+}
+
+std::string RUNTIME_DIR = ".";
 
-    if(type == FileType::Object){
+bool FindAssembler(CompileJob& job, std::string& assembler){
+    assembler = job.assembler;
+    if(job.type == FileType::Object || job.type == FileType::Executable){
         if(assembler.empty()){
             assembler = "as";
         }
         if(!CheckAvailable(assembler.c_str())){
-            std::cerr<<"bf++: error: Assembler "<<assembler<<" not found"<<std::endl;
+            Diag()<<"bf++: error: Assembler "<<assembler<<" not found"<<std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void SetSourcePaths(ParsedContext& parsed, std::string& input){
+    size_t slash = input.find_last_of('/');
+    if(slash != std::string::npos){
+        parsed.sourceDir = input.substr(0, slash);
+    }
+#ifdef _WIN32
+    char* full = _fullpath(nullptr, input.c_str(), 0);
+#else
+    char* full = realpath(input.c_str(), nullptr);
+#endif
+    parsed.sourcePath = full ? full : input;
+    std::free(full);
+}
+
+// spawns and the checked tape need the runtime, which needs libc
+inline bool NeedsRuntime(ParsedContext& parsed){
+    return CHECKED_TAPE || !parsed.spawns.empty() || !parsed.joins.empty();
+}
+
+bool PickLinker(CompileJob& job, ParsedContext& parsed, std::string& linker){
+    if(job.type != FileType::Executable){
+        return true;
+    }
+    bool hasMain = false;
+    for(Label& lbl : parsed.labels){
+        hasMain |= lbl.Name == "main";
+    }
+    if(!hasMain){
+        Diag()<<"bf++: error: executables need a main label"<<std::endl;
+        return false;
+    }
+    FREESTANDING = parsed.externs.empty() && !NeedsRuntime(parsed);
+    linker = FREESTANDING ? "ld" : "cc";
+    if(!CheckAvailable(linker.c_str())){
+        Diag()<<"bf++: error: Linker "<<linker<<" not found"<<std::endl;
+        return false;
+    }
+    return true;
+}
+
+// temporaries sit next to the output so concurrent compiles never share them
+inline std::string AssemblyOutput(CompileJob& job){
+    if(job.type == FileType::Assembly){
+        return job.output + job.ext;
+    }
+    return job.output + "__bfpp_temp.s";
+}
+
+int AssembleOutput(CompileJob& job, ParsedContext& parsed, std::string& assembler, std::string& linker, std::string& asmout){
+    std::string& output = job.output;
+    std::string& ext = job.ext;
+    if(job.type == FileType::Object){
+        std::string cmd = assembler + ' ';
+        cmd += asmout + " -o ";
+        cmd += output + ext;
+        int ret = std::system(cmd.c_str());
+        std::remove((asmout).c_str());
+        if(ret != 0){
+            Diag()<<"bf++: error: assembling "<<output + ext<<" failed"<<std::endl;
+            return 1;
+        }
+    }
+    else if(job.type == FileType::Executable){
+        std::string objout = output + "__bfpp_temp.o";
+        std::string cmd = assembler + ' ' + asmout + " -o " + objout;
+        int ret = std::system(cmd.c_str());
+        std::remove((asmout).c_str());
+        if(ret == 0){
+            if(FREESTANDING){
+                // static, no interpreter and nothing but our own _start
+                cmd = linker + " -static -o " + output + ' ' + objout;
+            }
+            else{
+                cmd = linker + ' ' + objout + " -o " + output;
+                if(NeedsRuntime(parsed)){
+                    cmd += " -L" + RUNTIME_DIR + " -lbfpprt -pthread";
+                }
+                // the externs of a program with float cells are most likely libm
+                for(WidthSwitch& sw : parsed.switches){
+                    if(IsFloatWidth(sw.to)){
+                        cmd += " -lm";
+                        break;
+                    }
+                }
+            }
+            ret = std::system(cmd.c_str());
+        }
+        std::remove(objout.c_str());
+        if(ret != 0){
+            Diag()<<"bf++: error: linking "<<output<<" failed"<<std::endl;
             return 1;
         }
     }
 
-    BFPPKWD bfpp;
+    return 0;
+}
+
+int CompileSource(CompileJob& job, std::string& file){
+    std::string assembler;
+    if(!FindAssembler(job, assembler)){
+        return 1;
+    }
+
+    BFPPKWD& bfpp = GetKeywords();
     BFPPRegisters regs;
 
-    std::string file = FileIntoString(input.c_str());
     if(file.empty()){
-        std::cout<<"bf++: error: File not found or empty"<<std::endl;
+        Diag()<<"bf++: error: File not found or empty"<<std::endl;
     }
     RemoveLineComments(file, ';');
 
-    std::vector<Tokenizer::Token> toks = Tokenizer::Tokenize(file);
+    // tokens and parser tables point into file, the arena frees them all when the compile returns
+    Arena arena;
+    ArenaVector<Tokenizer::Token> toks = Tokenizer::Tokenize(file, arena);
     ClassifyTokens(toks, bfpp);
 
     bool print = false;
@@ -1199,23 +5714,317 @@ int main(int argc, char** argv){
         std::cout<<std::endl;
     }
 
-    ParsedContext parsed = ParseTokensBFPP(toks, bfpp, regs);
-    std::string asmout;
-    if(type == FileType::Assembly){
-        asmout = output + ext;
+    ParsedContext parsed = ParseTokensBFPP(arena, toks, bfpp, regs);
+    SetSourcePaths(parsed, job.input);
+    if(parsed.parseFailed || !CheckSpawns(parsed) || !CheckIncludes(parsed)){
+        return 1;
     }
-    else{
-        asmout = "__temp_bfpp_assembly__file.s";
+    parsed.sourceHash = HashSource(file);
+    if(!PROFILE_USE.empty()){
+        LoadProfile(parsed, PROFILE_USE);
     }
-    BFPPCodegen(parsed, asmout.c_str());
-    
-    if(type == FileType::Object){
-        std::string cmd = assembler + ' ';
-        cmd += asmout + " -o ";
-        cmd += output + ext;
-        std::system(cmd.c_str());
-        std::remove((asmout).c_str());
+    std::string linker;
+    if(!PickLinker(job, parsed, linker)){
+        return 1;
     }
+    if(job.type == FileType::C){
+        std::string cout = job.output + job.ext;
+        return BFPPCodegenC(parsed, cout.c_str()) ? 0 : 1;
+    }
+    std::string asmout = AssemblyOutput(job);
+    if(!BFPPCodegen(parsed, asmout.c_str())){
+        return 1;
+    }
+    return AssembleOutput(job, parsed, assembler, linker, asmout);
+}
 
-    return 0;
-}
\ No newline at end of file
+// --stream, the labels are compiled as they are read and the checks that need the whole program run at the end
+int CompileStream(CompileJob& job, std::istream& in){
+    std::string assembler;
+    if(!FindAssembler(job, assembler)){
+        return 1;
+    }
+    if(job.type == FileType::C){
+        Diag()<<"bf++: error: --stream needs the assembly backend"<<std::endl;
+        return 1;
+    }
+    if(PROFILE_GENERATE || !PROFILE_USE.empty()){
+        Diag()<<"bf++: error: --stream cannot be used with profiles, it never sees the whole program"<<std::endl;
+        return 1;
+    }
+    if(!in || in.peek() == std::char_traits<char>::eof()){
+        Diag()<<"bf++: error: File not found or empty"<<std::endl;
+        return 1;
+    }
+
+    BFPPRegisters regs;
+    Arena arena;
+    ArenaVector<Tokenizer::Token> toks{ArenaAllocator<Tokenizer::Token>(arena)};
+    ParsedContext prog(arena, toks, GetKeywords(), regs);
+    SetSourcePaths(prog, job.input);
+
+    std::string asmout = AssemblyOutput(job);
+    std::ofstream file(asmout);
+    if(!file){
+        Diag()<<"Error opening file for codegen"<<std::endl;
+        return 1;
+    }
+    std::string linker;
+    bool ok = BFPPCodegenStream(prog, in, file) && CheckSpawns(prog) && CheckIncludes(prog) && PickLinker(job, prog, linker);
+    if(ok){
+        GenerateTail(prog, file);
+    }
+    file.close();
+    if(!ok){
+        std::remove(asmout.c_str());
+        return 1;
+    }
+    return AssembleOutput(job, prog, assembler, linker, asmout);
+}
+
+#ifndef _WIN32
+// compile server, requests and replies are length prefixed on a unix socket:
+// request  = u32 argument count, the arguments, the source
+// reply    = u32 exit status, the output file, diagnostics, --stats output
+// strings are a u32 length and the bytes
+
+bool ReadAll(int fd, void* buf, size_t len){
+    char* p = (char*)buf;
+    while(len > 0){
+        ssize_t n = read(fd, p, len);
+        if(n <= 0){
+            if(n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool WriteAll(int fd, const void* buf, size_t len){
+    const char* p = (const char*)buf;
+    while(len > 0){
+        ssize_t n = write(fd, p, len);
+        if(n <= 0){
+            if(n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool ReadString(int fd, std::string& str){
+    uint32_t len;
+    if(!ReadAll(fd, &len, sizeof(len))){
+        return false;
+    }
+    str.resize(len);
+    return ReadAll(fd, &str[0], len);
+}
+
+bool WriteString(int fd, const std::string& str){
+    uint32_t len = str.size();
+    return WriteAll(fd, &len, sizeof(len)) && WriteAll(fd, str.data(), len);
+}
+
+inline bool SocketAddress(const std::string& path, sockaddr_un& addr){
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(addr.sun_path)){
+        Diag()<<"bf++: error: socket path "<<path<<" is too long"<<std::endl;
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// one request per connection, each on its own thread so the options start from their defaults
+void ServeConnection(int fd){
+    std::ostringstream diag, report;
+    DIAGNOSTICS = &diag;
+    REPORT = &report;
+
+    uint32_t argc = 0;
+    std::vector<std::string> args;
+    std::string source;
+    bool ok = ReadAll(fd, &argc, sizeof(argc));
+    for(uint32_t i = 0; ok && i < argc; i++){
+        args.emplace_back();
+        ok = ReadString(fd, args.back());
+    }
+    ok = ok && ReadString(fd, source);
+    if(!ok){
+        close(fd);
+        return;
+    }
+
+    uint32_t status = 1;
+    std::string result;
+    CompileJob job;
+    char dir[] = "/tmp/bfpp-server-XXXXXX";
+    bool madeDir = false;
+    // anything the compile throws becomes a failed request instead of terminating the server
+    try{
+        if(ParseArguments(args, job)){
+            if(mkdtemp(dir) == nullptr){
+                Diag()<<"bf++: error: no temporary directory for the compile"<<std::endl;
+            }
+            else{
+                madeDir = true;
+                // the client writes the real output, the server compiles into a private directory
+                job.output = std::string(dir) + "/out";
+                if(STREAM){
+                    std::istringstream in(source);
+                    status = CompileStream(job, in);
+                }
+                else{
+                    status = CompileSource(job, source);
+                }
+                std::string produced = job.output + job.ext;
+                if(status == 0){
+                    result = FileIntoString(produced.c_str());
+                }
+                std::remove(produced.c_str());
+                rmdir(dir);
+                madeDir = false;
+            }
+        }
+    }
+    catch(const std::exception& e){
+        Diag()<<"bf++: error: "<<e.what()<<std::endl;
+        status = 1;
+        if(madeDir){
+            std::remove((job.output + job.ext).c_str());
+            rmdir(dir);
+        }
+    }
+    WriteAll(fd, &status, sizeof(status)) && WriteString(fd, result) &&
+        WriteString(fd, diag.str()) && WriteString(fd, report.str());
+    close(fd);
+}
+
+int RunServer(CompileJob& job){
+    sockaddr_un addr;
+    if(!SocketAddress(job.socket, addr)){
+        return 1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(job.socket.c_str());
+    if(fd < 0 || bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 128) != 0){
+        Diag()<<"bf++: error: cannot listen on "<<job.socket<<std::endl;
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    // warm everything a compile would otherwise set up on first use
+    std::string empty;
+    Arena arena;
+    Tokenizer::Tokenize(empty, arena);
+    GetKeywords();
+    CheckAvailable("as");
+    CheckAvailable("ld");
+    CheckAvailable("cc");
+
+    while(true){
+        int conn = accept(fd, nullptr, nullptr);
+        if(conn < 0){
+            if(errno == EINTR) continue;
+            Diag()<<"bf++: error: accept failed on "<<job.socket<<std::endl;
+            return 1;
+        }
+        std::thread(ServeConnection, conn).detach();
+    }
+}
+
+int RunClient(CompileJob& job, std::vector<std::string>& args){
+    std::string source = FileIntoString(job.input.c_str());
+    sockaddr_un addr;
+    if(!SocketAddress(job.socket, addr)){
+        return 1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0){
+        Diag()<<"bf++: error: no server on "<<job.socket<<std::endl;
+        return 1;
+    }
+    // everything but the --client pair goes to the server, which reads the profile and
+    // included files from our directory
+    std::vector<std::string> forward;
+    for(size_t i = 0; i < args.size(); i++){
+        if(args[i] == "--client"){
+            i++;
+            continue;
+        }
+        if(args[i] == job.input){
+            char* path = realpath(args[i].c_str(), nullptr);
+            forward.push_back(path ? path : args[i]);
+            std::free(path);
+            continue;
+        }
+        forward.push_back(args[i]);
+        if(args[i] == "--profile-use" && i + 1 < args.size()){
+            char* path = realpath(args[++i].c_str(), nullptr);
+            forward.push_back(path ? path : args[i]);
+            std::free(path);
+        }
+    }
+    uint32_t argc = forward.size();
+    bool ok = WriteAll(fd, &argc, sizeof(argc));
+    for(std::string& arg : forward){
+        ok = ok && WriteString(fd, arg);
+    }
+    ok = ok && WriteString(fd, source);
+
+    uint32_t status = 1;
+    std::string result, diag, report;
+    ok = ok && ReadAll(fd, &status, sizeof(status)) && ReadString(fd, result) &&
+        ReadString(fd, diag) && ReadString(fd, report);
+    close(fd);
+    if(!ok){
+        Diag()<<"bf++: error: lost the connection to "<<job.socket<<std::endl;
+        return 1;
+    }
+    Diag()<<diag;
+    Report()<<report;
+    if(status == 0){
+        std::string path = job.output + job.ext;
+        std::ofstream out(path, std::ios::binary);
+        out<<result;
+        out.close();
+        if(job.type == FileType::Executable){
+            chmod(path.c_str(), 0755);
+        }
+    }
+    return status;
+}
+#endif
+
+int main(int argc, char** argv){
+    if(argc <= 1){
+        Diag()<<"bf++: error: no input files"<<std::endl;
+        return 1;
+    }
+    RUNTIME_DIR = GetRuntimeDir(argv[0]);
+    std::vector<std::string> args(argv + 1, argv + argc);
+    CompileJob job;
+    if(!ParseArguments(args, job)){
+        return 1;
+    }
+    if(job.serve || job.client){
+#ifndef _WIN32
+        return job.serve ? RunServer(job) : RunClient(job, args);
+#else
+        Diag()<<"bf++: error: the compile server needs unix sockets"<<std::endl;
+        return 1;
+#endif
+    }
+    if(STREAM){
+        std::ifstream in(job.input, std::ios::binary);
+        return CompileStream(job, in);
+    }
+    std::string file = FileIntoString(job.input.c_str());
+    return CompileSource(job, file);
+}
@@ -0,0 +1,7 @@
+; ?bin without a name or with a register that does not exist fails the compile
+?include_bin table "bin_data.dat"
+@main:i32
+?bin table 99999999999999999999999
+?bin 3
+?mov 0
+!
@@ -0,0 +1,6 @@
+; a checkpoint needs a name, anything else fails the compile
+@main:i32
+?save 3
+?restore +
+?mov 0
+!
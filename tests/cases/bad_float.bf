@@ -0,0 +1,6 @@
+; float literals that overflow or have junk after them fail the compile instead of becoming 1.0
+@main:i32
+?f64 ?mov 1e999
+?f32 ?mov 1e39
+?step 1.5x
+?mov
@@ -0,0 +1,7 @@
+; ?write and ?read counts that cannot be used fail the compile instead of moving nothing
+@main:i32
+?write -3
+?read 0x1ffffffff
+?mov 0
+!
+?write
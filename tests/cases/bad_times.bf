@@ -0,0 +1,6 @@
+; ?times counts that cannot be used fail the compile instead of becoming some other loop
+@main:i32
+?times 99999999999999999999999 [ . ]
+?times foo [ . ]
+?mov 0
+!
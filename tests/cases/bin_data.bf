@@ -0,0 +1,10 @@
+; ?include_bin data read through the tape pointer
+?include_bin table "bin_data.dat"
+@main:i32
+?i64 ******^ ?i8
+?bin table
+.>.
+?i64 &&&&&&^ ?i8
+?mov 10 .
+?i32 ?mov 0
+!
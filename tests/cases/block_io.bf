@@ -0,0 +1,8 @@
+; ?read fills a run of cells from stdin and ?write prints them in one go
+@main:i32
+?i8
+?read 6
+>>>>> - <<<<<
+?write 0x6
+?i32 ?mov 0
+!
@@ -0,0 +1,3 @@
+=1 movl \$1, %edi
+=1 movl \$1, %edx
+=2 movq %rbp, %rsi
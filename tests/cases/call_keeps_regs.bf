@@ -0,0 +1,10 @@
+; quiet never touches %rdi, %rsi or %rdx, so the '.' after calling it reuses the setup of the '.' before
+@main:i32
+?i8 ?mov 65 .
+> ?call quiet <
+.
+> ?mov 10 .
+?i32 ?mov 0
+!
+@quiet:i8
+?mov 7 !
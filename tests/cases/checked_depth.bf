@@ -0,0 +1,7 @@
+; recursion without an end runs out of checked tape slots and says where
+@main:i32
+?call deep
+?i32 ?mov 0
+!
+@deep:i8
+?mov 1 > ?call deep < !
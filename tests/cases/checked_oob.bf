@@ -0,0 +1,6 @@
+; walking off the checked tape stops the program with the label and line of the access
+@main:i32
+?i8 ?mov 1
+[ > + ]
+?i32 ?mov 0
+!
@@ -0,0 +1,13 @@
+; ?restore across a '.', a ?call and inside a ?times loop, the callee uses a checkpoint and a counter of its own
+@main:i32
+?i8 ?mov 72 ?save start
+> ?mov 105 > ?mov 10
+?restore start .
+>> ?call mark ?restore start > .
+?times 3 [ > + ?restore start ]
+. >> . ?mov 10 .
+?i32 ?mov 0
+!
+@mark:i8
+?save here > ?times 4 [ > ] ?mov 0 ?restore here
+?mov 33 !
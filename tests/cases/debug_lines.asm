@@ -0,0 +1,5 @@
++\.file 1 ".*debug_lines\.bf"
+=2 \.cfi_startproc
+=2 \.cfi_endproc
++\.loc 1 3
++\.loc 1 8
@@ -0,0 +1,8 @@
+; -g tags every instruction with its source line and describes each frame for the unwinder
+@main:i32
+?call greet
+?mov 10 .
+?i32 ?mov 0
+!
+@greet:i8
+?mov 72 . ?mov 105 . !
@@ -0,0 +1,11 @@
+; float loops counted down by exponent and hex float literals, the i8 cell after them counts the iterations
+@main:i32
+?i64 > ?i8 ?mov 60 ?i64 <
+?f64 ?mov 1e1 ?step 0x1p-1
+[ - ?i64 > ?i8 + ?i64 < ?f64 ]
+?i64 > ?i8 . ?i64 <
+?f32 ?mov 0.5e+1 ?step 2.5E-1
+[ - ?i64 > ?i8 + ?i64 < ?f32 ]
+?i64 > ?i8 . ?mov 10 .
+?i32 ?mov 0
+!
@@ -0,0 +1,2 @@
++\.set b, a
+-^dead:
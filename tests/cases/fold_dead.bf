@@ -0,0 +1,13 @@
+; a and b have the same body, b becomes an alias of a, dead is never called and is dropped
+@main:i32
+?call a .
+?call b .
+?mov 10 .
+?mov 0
+!
+@a:i8
+?mov 72 !
+@b:i8
+?mov 72 !
+@dead
+?mov 33 .
@@ -0,0 +1,15 @@
+; main calls labels that are only defined further down, each label has loops of its own
+; so --stream has to renumber them and keep the line marks of every chunk
+@main:i32
+?i8 ?mov 3
+[ > ?call later . < - ]
+> ?call shout .
+?mov 10 .
+?i32 ?mov 0
+!
+@later:i8
+> ?mov 4 [ < + > - ] < ?mov 0 ?call last !
+@last:i8
+?mov 2 [ > ?mov 30 < - ] > ?mov 31 + [ > ++ < - ] > ?mov 66 !
+@shout:i8
+?times 2 [ ] ?mov 33 !
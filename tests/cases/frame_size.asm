@@ -0,0 +1,3 @@
+=2 subq \$144, %rsp
++subq \$672, %rsp
++subq \$16384, %rsp
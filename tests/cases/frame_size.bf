@@ -0,0 +1,12 @@
+; labels reserve only the cells they reach, a label whose movement is not static keeps the full --stack
+@main:i32
+?call small ?call wide ?call unbounded
+?mov 10 .
+?i32 ?mov 0
+!
+@small:i8
+?mov 65 . !
+@wide:i8
+>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> ?mov 66 . !
+@unbounded:i8
+?mov 0 > ?mov 1 > ?mov 1 > ?mov 1 [<] ?mov 67 . !
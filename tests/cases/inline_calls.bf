@@ -0,0 +1,9 @@
+; a short label called in a loop, inlined by default
+@main:i32
+?mov 3
+[>?call dbl.<-]
+?mov 10 .
+?mov 0
+!
+@dbl:i8
+>?mov 4<?mov 5[>+++++++++++++<-]>++++!
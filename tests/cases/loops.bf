@@ -0,0 +1,6 @@
+; a counted output loop, rotated with its test at the bottom
+@main:i32
+?i8
+>>?mov 65>?mov 26[<.+>-]<<?mov 10 .
+?mov 0
+!
@@ -0,0 +1,7 @@
+; the outer loop tests its i32 cell after an inner i8 loop that ended in i32 mode
+@main:i32
+?i32 ?mov 258 >?mov 65<
+[ >.< - ?i8 [ - ?i32 ] ]
+>?mov 10 .<
+?mov 0
+!
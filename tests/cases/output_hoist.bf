@@ -0,0 +1,7 @@
+; a '.' in a loop, the syscall setup is hoisted in front of it and reused every iteration
+@main:i32
+?i8 ?mov 5 > ?mov 65 <
+[ > . + < - ]
+> ?mov 10 .
+?i32 ?mov 0
+!
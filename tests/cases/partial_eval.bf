@@ -0,0 +1,10 @@
+; main only computes, the default compile runs it at compile time, --partial-eval 0 at run time
+@main:i32
+++++++[>++++++++++<-]>+++++ .
+?call next .
+?times 3 [ + . ]
+?mov 10 .
+?mov 0
+!
+@next:i8
+?mov 65 +!
@@ -0,0 +1,9 @@
+; a call in a loop of main, every call is interpreted at compile time unless the budget runs out
+@main:i32
+?i8 ?mov 66 > ?mov 0 <
+[ >> ?call one < + < - ]
+> . > ?mov 10 .
+<< ?i32 ?mov 0
+!
+@one:i8
+?mov 1 !
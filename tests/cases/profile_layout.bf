@@ -0,0 +1,11 @@
+; a profile moves the label that never ran into .text.unlikely, the one that ran stays hot
+@main:i32
+, [ ?call rare ?mov 0 ]
+?mov 3 [ > ?call often < - ]
+?mov 10 .
+?i32 ?mov 0
+!
+@often:i8
+?mov 42 . !
+@rare:i8
+?mov 63 . !
@@ -0,0 +1,20 @@
+; a million nested calls, each with its own frame, then 42 on the way back out
+?extern putchar
+@main:i32
+?i64
+?mov 1000000
+*
+?call count
+?i8
+?mov 10 .
+?mov 0
+!
+@count:i64
+?i64
+&
+[-*?call count!]
+?mov 42
+?i8
+.
+?i64
+!
@@ -0,0 +1,8 @@
+; [>] and [<] searches over a run of nonzero cells, lowered to the vector scan routines
+@main:i32
+?i8
+?mov 0 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > ?mov 3 > 
+?mov 0
+< [<] > [>] < . > ?mov 65 . ?mov 10 .
+?i32 ?mov 0
+!
@@ -0,0 +1,18 @@
+; three spawned doublings joined in spawn order
+?extern putchar
+@main:i32
+?i64
+?mov 30 * ?spawn dbl
+?mov 31 * ?spawn dbl
+?mov 32 * ?spawn dbl
+?join * ?call putchar
+?join * ?call putchar
+?join * ?call putchar
+?mov 10 * ?call putchar
+?mov 0
+!
+@dbl:i64
+?i64
+&
+>?mov 0<[->++<]>
+!
@@ -0,0 +1,13 @@
+; f hands its tape address to g in its last call, so the call must not reuse f's frame
+@main:i32
+?call f
+?mov 0
+!
+@f:i8
+?mov 72 > ?mov 105 <
+?i64 *^ ?call g !
+@g:i8
+?mov 88
+?i64 &^ ?i8
+. > . > ?mov 10 .
+!
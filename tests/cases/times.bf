@@ -0,0 +1,9 @@
+; ?times with immediate counts, unrolled by --unroll up to its limits on the factor and the copied ops
+@main:i32
+?i8 ?mov 60
+?times 5 [ + ]
+.
+?times 20 [ + > + > + < < ]
+> ?mov 10 .
+?i32 ?mov 0
+!
@@ -0,0 +1,12 @@
+; v128 and v256 cells, a loop on a 32 byte cell adds to a 16 byte one
+?extern putchar
+@main:i32
+?v128
+?mov 65 >
+?v256
+?mov 3
+[ - ?v128 < + > ?v256 ]
+?v128 < ?i8 . ?mov 10 .
+?v128 > ?mov 5 [-]
+?i32 ?mov 0
+!
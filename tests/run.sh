@@ -0,0 +1,150 @@
+#!/bin/sh
+# compiles and runs every tests/cases/NAME.bf and compares what it prints with NAME.out
+#   NAME.args  one set of compiler options per line, every set has to print the same (default: none)
+#              a line starting with "c" goes through the C backend and the system compiler
+#   NAME.in    standard input of the program
+#   NAME.asm   lines "+regex" and "-regex" the assembly of the first option set has to (not) contain,
+#              "=N regex" has to match exactly N lines
+#   NAME.fail  the compile has to fail, every line is a regex its diagnostics have to contain
+#   NAME.err   every line is a regex the program's stderr has to contain
+#   NAME.status  the exit status the program has to end with, 139 for SIGSEGV (default: not checked)
+# then lays out profile_layout.bf from a profile of its own run and compiles through a --server/--client pair
+# run from the repository root after make, BFPP overrides the compiler
+
+BFPP=${BFPP:-bin/bfpp}
+CASES=tests/cases
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+pass=0
+fail=0
+
+for src in "$CASES"/*.bf; do
+    name=$(basename "$src" .bf)
+    input=/dev/null
+    [ -f "$CASES/$name.in" ] && input="$CASES/$name.in"
+    if [ -f "$CASES/$name.args" ]; then
+        variants=$(cat "$CASES/$name.args")
+    else
+        variants="-"
+    fi
+    ok=1
+    first=1
+    # one option set per line
+    while IFS= read -r opts; do
+        [ "$opts" = "-" ] && opts=""
+        exe="$TMP/$name"
+        rm -f "$exe" "$exe.c" "$exe.s"
+        case "$opts" in
+            c|c\ *)
+                # shellcheck disable=SC2086
+                "$BFPP" "$src" -o "$exe.c" ${opts#c} >"$TMP/log" 2>&1 && cc -O1 -Wall -Werror "$exe.c" -o "$exe" -lm >>"$TMP/log" 2>&1
+                ;;
+            *)
+                # shellcheck disable=SC2086
+                "$BFPP" "$src" -o "$exe" $opts >"$TMP/log" 2>&1
+                ;;
+        esac
+        status=$?
+        if [ -f "$CASES/$name.fail" ]; then
+            if [ $status -eq 0 ]; then
+                echo "FAIL $name [$opts]: compile did not fail"
+                ok=0
+            fi
+            while IFS= read -r line; do
+                grep -Eq "$line" "$TMP/log" || { echo "FAIL $name [$opts]: no diagnostic $line"; ok=0; }
+            done <"$CASES/$name.fail"
+            continue
+        fi
+        if [ $status -ne 0 ]; then
+            echo "FAIL $name [$opts]: compile failed"
+            sed 's/^/    /' "$TMP/log"
+            ok=0
+            continue
+        fi
+        # the outer redirection keeps the shell's own "Segmentation fault" note out of the report
+        { (cd "$TMP" && exec timeout 10 "./$name") <"$input" >"$TMP/got" 2>"$TMP/err"; status=$?; } 2>/dev/null
+        if ! cmp -s "$TMP/got" "$CASES/$name.out"; then
+            echo "FAIL $name [$opts]: output differs"
+            ok=0
+        fi
+        if [ -f "$CASES/$name.status" ] && [ $status -ne "$(cat "$CASES/$name.status")" ]; then
+            echo "FAIL $name [$opts]: exit status $status"
+            ok=0
+        fi
+        if [ -f "$CASES/$name.err" ]; then
+            while IFS= read -r line; do
+                grep -Eq "$line" "$TMP/err" || { echo "FAIL $name [$opts]: stderr lacks $line"; ok=0; }
+            done <"$CASES/$name.err"
+        fi
+        if [ $first -eq 1 ] && [ -f "$CASES/$name.asm" ]; then
+            # shellcheck disable=SC2086
+            "$BFPP" "$src" -o "$exe.s" $opts >/dev/null 2>&1
+            while IFS= read -r line; do
+                pattern=${line#?}
+                case "$line" in
+                    +*) grep -Eq "$pattern" "$exe.s" || { echo "FAIL $name: assembly lacks $pattern"; ok=0; } ;;
+                    -*) grep -Eq "$pattern" "$exe.s" && { echo "FAIL $name: assembly has $pattern"; ok=0; } ;;
+                    =*)
+                        want=${pattern%% *}
+                        pattern=${pattern#* }
+                        got=$(grep -Ec "$pattern" "$exe.s")
+                        [ "$got" -eq "$want" ] || { echo "FAIL $name: assembly has $got lines of $pattern, not $want"; ok=0; }
+                        ;;
+                esac
+            done <"$CASES/$name.asm"
+        fi
+        first=0
+    done <<VARIANTS
+$variants
+VARIANTS
+    if [ $ok -eq 1 ]; then
+        pass=$((pass + 1))
+    else
+        fail=$((fail + 1))
+    fi
+done
+
+# a --profile-generate run writes bfpp.prof next to the program, --profile-use then moves the label that never ran
+profile_ok=0
+rm -f "$TMP/bfpp.prof"
+"$BFPP" "$CASES/profile_layout.bf" -o "$TMP/profiled" --profile-generate >"$TMP/log" 2>&1 &&
+    (cd "$TMP" && timeout 10 ./profiled) <"$CASES/profile_layout.in" >/dev/null 2>&1 &&
+    "$BFPP" "$CASES/profile_layout.bf" -o "$TMP/profiled.s" --profile-use "$TMP/bfpp.prof" >"$TMP/log" 2>&1 &&
+    grep -A3 "^[[:space:]]*\.section \.text\.unlikely\.rare," "$TMP/profiled.s" | grep -q "^rare:" &&
+    grep -q "^[[:space:]]*\.section \.text\.main," "$TMP/profiled.s" && profile_ok=1
+if [ $profile_ok -eq 1 ]; then
+    pass=$((pass + 1))
+else
+    echo "FAIL profile: rare is not in .text.unlikely after --profile-use"
+    fail=$((fail + 1))
+fi
+
+# the compile server: one good compile through --client, then bad requests that have to come back as failures
+server_ok=1
+"$BFPP" --server "$TMP/sock" >"$TMP/server.log" 2>&1 &
+server=$!
+tries=0
+while [ ! -S "$TMP/sock" ] && [ $tries -lt 50 ]; do
+    sleep 0.1
+    tries=$((tries + 1))
+done
+"$BFPP" --client "$TMP/sock" "$CASES/loops.bf" -o "$TMP/served" >"$TMP/log" 2>&1 &&
+    (cd "$TMP" && timeout 10 ./served) </dev/null >"$TMP/got" 2>/dev/null &&
+    cmp -s "$TMP/got" "$CASES/loops.out" || { echo "FAIL server: compile through --client"; server_ok=0; }
+"$BFPP" --client "$TMP/sock" "$CASES/loops.bf" -o "$TMP/served" --stack abc >"$TMP/log" 2>&1
+status=$?
+[ $status -eq 1 ] && grep -q -- "--stack expects a number, got 'abc'" "$TMP/log" || { echo "FAIL server: --stack abc gave status $status"; server_ok=0; }
+"$BFPP" --client "$TMP/sock" "$CASES/bad_times.bf" -o "$TMP/served.s" >"$TMP/log" 2>&1
+status=$?
+[ $status -eq 1 ] && grep -q "Unknown value on times instruction" "$TMP/log" || { echo "FAIL server: bad source gave status $status"; server_ok=0; }
+"$BFPP" --client "$TMP/sock" "$CASES/loops.bf" -o "$TMP/served.s" >"$TMP/log" 2>&1 || { echo "FAIL server: no compile after a failed one"; server_ok=0; }
+kill $server 2>/dev/null
+wait $server 2>/dev/null
+if [ $server_ok -eq 1 ]; then
+    pass=$((pass + 1))
+else
+    fail=$((fail + 1))
+fi
+
+echo "$pass passed, $fail failed"
+[ $fail -eq 0 ]